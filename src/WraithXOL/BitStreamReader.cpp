@@ -0,0 +1,83 @@
+#include "stdafx.h"
+
+// The class we are implementing
+#include "BitStreamReader.h"
+
+BitStreamReader::BitStreamReader(const uint8_t* Buffer, uint64_t BufferSize)
+{
+	// Assign
+	this->Buffer = Buffer;
+	this->BufferSize = BufferSize;
+}
+
+BitStreamReader::~BitStreamReader()
+{
+	// Default
+}
+
+uint64_t BitStreamReader::ReadBits(uint64_t BitIndex, uint32_t NumBits) const
+{
+	// Nothing to read
+	if (NumBits == 0)
+		return 0;
+
+	// Calculate the position
+	auto ByteIndex = BitIndex >> 3;
+	auto BitShift = (uint32_t)(BitIndex & 7);
+
+	// Load the word containing the start of the field
+	auto Result = this->LoadWord(ByteIndex) >> BitShift;
+
+	// A field that doesn't start on a byte can spill into a 9th byte
+	if (BitShift + NumBits > 64)
+		Result |= (this->LoadWord(ByteIndex + 8) << (64 - BitShift));
+
+	// Mask off the rest
+	if (NumBits < 64)
+		Result &= ((uint64_t)1 << NumBits) - 1;
+
+	// Return it
+	return Result;
+}
+
+void BitStreamReader::ReadRecords(uint64_t BitIndex, uint32_t RecordCount, uint32_t RecordBits, const uint32_t* FieldBits, uint32_t FieldCount, uint64_t* const* Columns) const
+{
+	// Iterate over the records
+	for (uint32_t i = 0; i < RecordCount; i++)
+	{
+		// Start of this record
+		auto FieldIndex = BitIndex;
+
+		// Read each field into its column
+		for (uint32_t j = 0; j < FieldCount; j++)
+		{
+			// Read it
+			Columns[j][i] = this->ReadBits(FieldIndex, FieldBits[j]);
+			// Advance
+			FieldIndex += FieldBits[j];
+		}
+
+		// Advance to the next record
+		BitIndex += RecordBits;
+	}
+}
+
+uint64_t BitStreamReader::LoadWord(uint64_t ByteIndex) const
+{
+	// Result buffer
+	uint64_t Result = 0;
+
+	// Unaligned load when the whole word is in the buffer
+	if (ByteIndex + 8 <= this->BufferSize)
+	{
+		std::memcpy(&Result, this->Buffer + ByteIndex, 8);
+		return Result;
+	}
+
+	// Near the end, only load what's left
+	for (uint32_t i = 0; (ByteIndex + i) < this->BufferSize && i < 8; i++)
+		Result |= ((uint64_t)this->Buffer[ByteIndex + i] << (i * 8));
+
+	// Return it
+	return Result;
+}
\ No newline at end of file
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdint>
+
+// A class that reads little-endian bit fields of up to 64 bits from a buffer, a word at a time
+class BitStreamReader
+{
+public:
+	// Constructors
+	BitStreamReader(const uint8_t* Buffer, uint64_t BufferSize);
+	~BitStreamReader();
+
+	// Reads a field of NumBits (0-64) starting at the given bit
+	uint64_t ReadBits(uint64_t BitIndex, uint32_t NumBits) const;
+
+	// Decodes fixed-size records into columns in one pass, each record holds FieldCount fields of FieldBits[i] bits, the rest of the record is skipped
+	void ReadRecords(uint64_t BitIndex, uint32_t RecordCount, uint32_t RecordBits, const uint32_t* FieldBits, uint32_t FieldCount, uint64_t* const* Columns) const;
+
+private:
+	// The buffer we are reading
+	const uint8_t* Buffer;
+	// The size of the buffer
+	uint64_t BufferSize;
+
+	// Loads 8 bytes from the given byte, zero-filled past the end of the buffer
+	uint64_t LoadWord(uint64_t ByteIndex) const;
+};
\ No newline at end of file
@@ -198,4 +198,39 @@ std::unique_ptr<XImageDDS> CoDIWITranslator::TranslateIWI(const std::unique_ptr<
 
 	// Failed to convert
 	return nullptr;
+}
+
+bool CoDIWITranslator::ReadIWIInfo(const uint8_t* IWIBuffer, uint32_t IWIBufferSize, XImageInfo& Result)
+{
+	// We need the header, and the info
+	if (IWIBuffer == nullptr || IWIBufferSize < (sizeof(IWIHeader) + sizeof(IWIInfo)))
+		return false;
+
+	// Read the header
+	IWIHeader Header;
+	std::memcpy(&Header, IWIBuffer, sizeof(IWIHeader));
+
+	// Verify magic (IWi)
+	if (Header.Magic[0] != 0x49 || Header.Magic[1] != 0x57 || Header.Magic[2] != 0x69)
+		return false;
+
+	// Check if we need to skip, the same as when translating
+	uint32_t InfoOffset = (Header.Version == 0x8 || Header.Version == 0x9) ? 8 : sizeof(IWIHeader);
+	// Verify it
+	if (IWIBufferSize < (InfoOffset + sizeof(IWIInfo)))
+		return false;
+
+	// Read the info
+	IWIInfo Info;
+	std::memcpy(&Info, IWIBuffer + InfoOffset, sizeof(IWIInfo));
+
+	// Assign it
+	Result.Version = Header.Version;
+	Result.ImageFormat = Info.ImageFormat;
+	Result.ImageFlags = Info.ImageFlags;
+	Result.ImageWidth = Info.ImageWidth;
+	Result.ImageHeight = Info.ImageHeight;
+
+	// Success
+	return true;
 }
\ No newline at end of file
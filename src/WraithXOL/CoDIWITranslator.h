@@ -6,6 +6,9 @@
 // We need the Asset types
 #include "CoDXAssets.h"
 
+// The bytes of an IWI needed to read its info, the header and info are within this for every version
+#define IWI_INFO_SIZE 0x10
+
 // A class that handles converting IWI files to DDS files in memory
 class CoDIWITranslator
 {
@@ -14,4 +17,7 @@ public:
 
 	// Translates an IWI file to a DDS file
 	static std::unique_ptr<XImageDDS> TranslateIWI(const std::unique_ptr<uint8_t[]>& IWIBuffer, uint32_t IWIBufferSize);
+
+	// Reads the info of an IWI file, without its image data, only the first IWI_INFO_SIZE bytes are needed
+	static bool ReadIWIInfo(const uint8_t* IWIBuffer, uint32_t IWIBufferSize, XImageInfo& Result);
 };
\ No newline at end of file
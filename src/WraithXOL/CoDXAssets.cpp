@@ -111,4 +111,14 @@ XImageDDS::~XImageDDS()
 		// Delete it
 		delete[] DataBuffer;
 	}
+}
+
+XImageInfo::XImageInfo()
+{
+	// Defaults
+	Version = 0;
+	ImageFormat = 0;
+	ImageFlags = 0;
+	ImageWidth = 0;
+	ImageHeight = 0;
 }
\ No newline at end of file
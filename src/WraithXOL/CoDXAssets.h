@@ -251,4 +251,21 @@ struct XImageDDS
 
 	// The requested image patch type
 	ImagePatch ImagePatchType;
+};
+
+struct XImageInfo
+{
+	// Constructors
+	XImageInfo();
+
+	// The IWI version
+	uint8_t Version;
+	// The IWI image format
+	uint8_t ImageFormat;
+	// The IWI image flags
+	uint8_t ImageFlags;
+
+	// The size of the image
+	uint16_t ImageWidth;
+	uint16_t ImageHeight;
 };
\ No newline at end of file
@@ -27,6 +27,9 @@
 #include "XMEExport.h"
 #include "ValveSMDExport.h"
 
+// We need the following std classes
+#include <unordered_set>
+
 // -- Initialize built-in game offsets databases
 
 // Online
@@ -77,17 +80,21 @@ bool GameOnline::LoadGame()
 		// Fetch game path, mount IFS directory
 		auto GamePath = FileSystems::GetDirectoryName(GameInstance->GetProcessPath());
 		auto GameIIPSPath = FileSystems::CombinePath(GamePath, "IIPS\\IIPSDownload");
+		// The mount index, unchanged packages are loaded from it next time
+		auto GameIndexPath = FileSystems::CombinePath(FileSystems::GetApplicationPath(), "codol_ifs.idx");
 
 		// Mount the IFSLibrary
 		GameOnline::IFSLibrary = std::make_unique<IFSLib>();
-		// Mount it
-		GameOnline::IFSLibrary->MountIFSPath(GameIIPSPath);
+		// Mount it in the background, lookups only wait on the packages they need
+		GameOnline::IFSLibrary->MountIFSPathAsync(GameIIPSPath, GameIndexPath);
+		// Keep decoded entries, shared images are read for many materials (256MB)
+		GameOnline::IFSLibrary->SetCacheBudget(0x10000000);
 
 		// Load image converter
 		Image::SetupConversionThread();
 
 		// Log results
-		Console::WriteLineHeader("IFS", "Mounted IFS directory, loaded %d files", GameOnline::IFSLibrary->GetLoadedEntries());
+		Console::WriteLineHeader("IFS", "Mounting IFS directory in the background, lookups wait on it as needed");
 
 		// Success
 		return true;
@@ -792,57 +799,71 @@ void GameOnline::ExportMaterialImages(const XMaterial_t& Material, const std::st
 	// Extension
 	auto Extension = (GameOnline::ExportConfiguration.PNG) ? ".png" : ".dds";
 
-	// Iterate and export if not exists
+	// The images we need to extract, they are read together in package order
+	std::vector<std::string> ImageFiles;
+	std::vector<const XImage_t*> ImageAssets;
+	// The images already queued, a material can use the same one in several slots
+	std::unordered_set<std::string> QueuedImages;
+
+	// Iterate and queue if not exists
 	for (auto& Image : Material.Images)
 	{
+		// Only queue each image once
+		if (!QueuedImages.insert(Image.ImageName).second)
+			continue;
+
 		// Grab the full image path, if it doesn't exist convert it!
 		auto FullImagePath = FileSystems::CombinePath(ImageRoot, Image.ImageName + Extension);
 		// Check if it exists
 		if (!FileSystems::FileExists(FullImagePath))
 		{
-			// If we're gonna extract, prepare to extract it...
-			uint32_t ResultSize = 0;
-			// Load the image, if possible
-			auto LoadResult = GameOnline::IFSLibrary->ReadFileEntry(Image.ImageName + ".iwi", ResultSize);
+			// Queue it
+			ImageFiles.emplace_back(Image.ImageName + ".iwi");
+			ImageAssets.emplace_back(&Image);
+		}
+	}
 
-			// If we loaded, convert to a DDS
-			if (LoadResult != nullptr)
-			{
-				// Convert it
-				auto IWIConv = CoDIWITranslator::TranslateIWI(LoadResult, ResultSize);
+	// Load the images, if possible, each one is converted as soon as it's decoded
+	GameOnline::IFSLibrary->ReadFileEntries(ImageFiles, [&ImageAssets, &ImageRoot, Extension](size_t Index, std::unique_ptr<uint8_t[]>& LoadResult, uint32_t ResultSize)
+	{
+		// Grab the image
+		auto& Image = *ImageAssets[Index];
+		// Grab the full image path
+		auto FullImagePath = FileSystems::CombinePath(ImageRoot, Image.ImageName + Extension);
 
-				// On success, write to format
-				if (IWIConv != nullptr)
-				{
-					// Patch
-					auto ImagePatch = (Image.ImageUsage == ImageUsageType::NormalMap) ? ImagePatch::Normal_Bumpmap : ImagePatch::NoPatch;
+		// Convert it
+		auto IWIConv = CoDIWITranslator::TranslateIWI(LoadResult, ResultSize);
 
-					// Save to PNG
-					if (GameOnline::ExportConfiguration.PNG)
-						Image::ConvertImageMemory(IWIConv->DataBuffer, IWIConv->DataSize, ImageFormat::DDS_WithHeader, FullImagePath, ImageFormat::Standard_PNG, ImagePatch);
+		// On success, write to format
+		if (IWIConv != nullptr)
+		{
+			// Patch
+			auto ImagePatch = (Image.ImageUsage == ImageUsageType::NormalMap) ? ImagePatch::Normal_Bumpmap : ImagePatch::NoPatch;
 
-					// Save to DDS
-					if (GameOnline::ExportConfiguration.DDS)
-					{
-						try
-						{
-							// Prepare writer
-							auto Writer = BinaryWriter();
-							// Create new image
-							Writer.Create(FullImagePath);
+			// Save to PNG
+			if (GameOnline::ExportConfiguration.PNG)
+				Image::ConvertImageMemory(IWIConv->DataBuffer, IWIConv->DataSize, ImageFormat::DDS_WithHeader, FullImagePath, ImageFormat::Standard_PNG, ImagePatch);
 
-							// Write it
-							Writer.Write(IWIConv->DataBuffer, IWIConv->DataSize);
-						}
-						catch (...)
-						{
-							// Nothing, already in access
-						}
-					}
+			// Save to DDS
+			if (GameOnline::ExportConfiguration.DDS)
+			{
+				try
+				{
+					// Prepare writer
+					auto Writer = BinaryWriter();
+					// Create new image
+					Writer.Create(FullImagePath);
+
+					// Write it
+					Writer.Write(IWIConv->DataBuffer, IWIConv->DataSize);
+				}
+				catch (...)
+				{
+					// Nothing, already in access
 				}
 			}
 		}
-	}
+	});
 }
 
 std::string GameOnline::LoadStringHandler(uint64_t Index)
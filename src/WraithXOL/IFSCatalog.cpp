@@ -0,0 +1,470 @@
+#include "stdafx.h"
+
+// The class we are implementing
+#include "IFSCatalog.h"
+
+// We need the following WraithX classes
+#include "FileSystems.h"
+#include "BinaryWriter.h"
+#include "Strings.h"
+
+// We need the following std classes
+#include <algorithm>
+#include <regex>
+
+// -- Verify structures
+
+static_assert(sizeof(IFSCatalogEntry) == 0x20, "Invalid IFSCatalogEntry Size (Expected 0x20)");
+
+// -- End verify
+
+// Folds a name character for comparing, ignoring case and slash direction
+inline char FoldCatalogChar(char Value)
+{
+	// Slashes are the same
+	if (Value == '\\')
+		return '/';
+
+	// Lowercase it
+	return (Value >= 'A' && Value <= 'Z') ? (char)(Value + ('a' - 'A')) : Value;
+}
+
+// Compares two names, folded, like strcmp
+int32_t CompareCatalogNames(const char* Lhs, size_t LhsLength, const char* Rhs, size_t RhsLength)
+{
+	// Compare the common part
+	auto Length = (LhsLength < RhsLength) ? LhsLength : RhsLength;
+	// Iterate
+	for (size_t i = 0; i < Length; i++)
+	{
+		// Fold them
+		auto L = (uint8_t)FoldCatalogChar(Lhs[i]);
+		auto R = (uint8_t)FoldCatalogChar(Rhs[i]);
+
+		// Check
+		if (L != R)
+			return (L < R) ? -1 : 1;
+	}
+
+	// The shorter one comes first
+	if (LhsLength == RhsLength)
+		return 0;
+
+	return (LhsLength < RhsLength) ? -1 : 1;
+}
+
+// Matches a name against a glob pattern, folded, * matches any run of characters, and ? any single one
+bool MatchCatalogGlob(const char* Name, size_t NameLength, const std::string& Pattern)
+{
+	// The positions, and where to go back to after a failed * match
+	size_t NamePos = 0, PatternPos = 0;
+	size_t StarPattern = std::string::npos, StarName = 0;
+
+	// Iterate
+	while (NamePos < NameLength)
+	{
+		// Check the pattern
+		if (PatternPos < Pattern.size() && Pattern[PatternPos] == '*')
+		{
+			// Remember it, first try matching nothing
+			StarPattern = PatternPos++;
+			StarName = NamePos;
+		}
+		else if (PatternPos < Pattern.size() && (Pattern[PatternPos] == '?' || FoldCatalogChar(Pattern[PatternPos]) == FoldCatalogChar(Name[NamePos])))
+		{
+			// Matched one
+			PatternPos++;
+			NamePos++;
+		}
+		else if (StarPattern != std::string::npos)
+		{
+			// Let the last * take one more character
+			PatternPos = StarPattern + 1;
+			NamePos = ++StarName;
+		}
+		else
+		{
+			// No match
+			return false;
+		}
+	}
+
+	// Only trailing * may be left
+	while (PatternPos < Pattern.size() && Pattern[PatternPos] == '*')
+		PatternPos++;
+
+	// Done
+	return (PatternPos == Pattern.size());
+}
+
+// Appends a value to a CSV line, quoting it if needed
+void AppendCatalogCSV(std::string& Output, const char* Value, size_t Length)
+{
+	// Check if it needs quotes
+	auto NeedsQuotes = false;
+	// Iterate
+	for (size_t i = 0; i < Length && !NeedsQuotes; i++)
+		NeedsQuotes = (Value[i] == ',' || Value[i] == '"' || Value[i] == '\r' || Value[i] == '\n');
+
+	// Write it as is
+	if (!NeedsQuotes)
+	{
+		Output.append(Value, Length);
+		return;
+	}
+
+	// Quote it, doubling any quotes
+	Output += '"';
+	// Iterate
+	for (size_t i = 0; i < Length; i++)
+	{
+		if (Value[i] == '"')
+			Output += '"';
+
+		Output += Value[i];
+	}
+	Output += '"';
+}
+
+// Appends a JSON string
+void AppendCatalogJSON(std::string& Output, const char* Value, size_t Length)
+{
+	// Open it
+	Output += '"';
+
+	// Escape each character
+	for (size_t i = 0; i < Length; i++)
+	{
+		// Grab it
+		auto Character = (uint8_t)Value[i];
+
+		// Check
+		if (Character == '"' || Character == '\\')
+		{
+			Output += '\\';
+			Output += (char)Character;
+		}
+		else if (Character < 0x20)
+		{
+			// Control characters are written as codes
+			Output += Strings::Format("\\u%04x", Character);
+		}
+		else
+		{
+			Output += (char)Character;
+		}
+	}
+
+	// Close it
+	Output += '"';
+}
+
+// Writes a text file in one go
+bool WriteCatalogFile(const std::string& FilePath, const std::string& Contents)
+{
+	// Whether or not the whole file was written
+	bool Written = false;
+
+	// Write it, the writer throws if the file is in use, or can't be written
+	try
+	{
+		// Prepare writer
+		auto Writer = BinaryWriter();
+		// Create it
+		if (Writer.Create(FilePath))
+		{
+			// Write it
+			if (!Contents.empty())
+				Writer.Write((int8_t*)&Contents[0], (uint32_t)Contents.size());
+
+			// Make sure nothing was cut short
+			Written = (Writer.GetPosition() == Contents.size());
+		}
+	}
+	catch (...)
+	{
+		// Failed
+		Written = false;
+	}
+
+	// Return result
+	return Written;
+}
+
+IFSCatalog::IFSCatalog()
+{
+	// Defaults
+	this->AbsentCount = 0;
+	this->AbsentSize = 0;
+}
+
+IFSCatalog::~IFSCatalog()
+{
+	// Default
+}
+
+uint32_t IFSCatalog::AddPackage(const std::string& PackagePath)
+{
+	// Add it
+	this->Packages.emplace_back(PackagePath);
+
+	// Return the index
+	return (uint32_t)(this->Packages.size() - 1);
+}
+
+void IFSCatalog::AddEntry(const char* Name, size_t NameLength, uint32_t PackageIndex, const IFSFileEntry& Entry)
+{
+	// Setup the entry
+	IFSCatalogEntry Result;
+	// Assign the name
+	Result.NameOffset = (uint32_t)this->NameTable.size();
+	Result.NameLength = (uint32_t)NameLength;
+	// Assign the rest
+	Result.PackageIndex = PackageIndex;
+	Result.Flags = (uint32_t)Entry.Flags;
+	Result.FilePosition = Entry.FilePosition;
+	Result.FileSize = (uint32_t)Entry.FileSize;
+	Result.CompressedSize = (uint32_t)Entry.CompressedSize;
+
+	// Copy the name
+	this->NameTable.insert(this->NameTable.end(), Name, Name + NameLength);
+	// Add it
+	this->Entries.emplace_back(Result);
+}
+
+void IFSCatalog::AddAbsent(const IFSFileEntry& Entry)
+{
+	// Count it
+	this->AbsentCount++;
+	this->AbsentSize += Entry.CompressedSize;
+}
+
+void IFSCatalog::Finalize()
+{
+	// Grab the names
+	auto Names = this->NameTable.data();
+
+	// Sort them by name
+	std::sort(this->Entries.begin(), this->Entries.end(), [Names](const IFSCatalogEntry& Lhs, const IFSCatalogEntry& Rhs)
+	{
+		return CompareCatalogNames(Names + Lhs.NameOffset, Lhs.NameLength, Names + Rhs.NameOffset, Rhs.NameLength) < 0;
+	});
+
+	// Release the spare capacity
+	this->NameTable.shrink_to_fit();
+	this->Entries.shrink_to_fit();
+}
+
+void IFSCatalog::Clear()
+{
+	// Remove everything
+	this->NameTable.clear();
+	this->Entries.clear();
+	this->Packages.clear();
+	this->AbsentCount = 0;
+	this->AbsentSize = 0;
+}
+
+size_t IFSCatalog::GetCount() const
+{
+	return this->Entries.size();
+}
+
+const IFSCatalogEntry& IFSCatalog::GetEntry(size_t Index) const
+{
+	return this->Entries[Index];
+}
+
+std::string IFSCatalog::GetName(size_t Index) const
+{
+	// Grab the entry
+	auto& Entry = this->Entries[Index];
+	// Copy out the name
+	return std::string(this->NameTable.data() + Entry.NameOffset, Entry.NameLength);
+}
+
+const std::string& IFSCatalog::GetPackagePath(uint32_t PackageIndex) const
+{
+	return this->Packages[PackageIndex];
+}
+
+uint64_t IFSCatalog::GetAbsentCount() const
+{
+	return this->AbsentCount;
+}
+
+uint64_t IFSCatalog::GetAbsentSize() const
+{
+	return this->AbsentSize;
+}
+
+bool IFSCatalog::Query(IFSCatalogQuery Type, const std::string& Pattern, std::vector<size_t>& Results) const
+{
+	// Reset the results
+	Results.clear();
+
+	// Grab the names
+	auto Names = this->NameTable.data();
+
+	// Check the type
+	switch (Type)
+	{
+	case IFSCatalogQuery::Prefix:
+	{
+		// Names are sorted, so the matches are one range
+		size_t Begin = 0, End = 0;
+		this->FindPrefixRange(Pattern, Begin, End);
+
+		// Add them
+		for (auto i = Begin; i < End; i++)
+			Results.emplace_back(i);
+
+		// Done
+		return true;
+	}
+	case IFSCatalogQuery::Glob:
+	{
+		// Only the names starting with the part before the first wildcard can match
+		auto LiteralLength = Pattern.find_first_of("*?");
+		// Find them
+		size_t Begin = 0, End = 0;
+		this->FindPrefixRange(Pattern.substr(0, LiteralLength), Begin, End);
+
+		// Match each one
+		for (auto i = Begin; i < End; i++)
+		{
+			// Grab the entry
+			auto& Entry = this->Entries[i];
+			// Check it
+			if (MatchCatalogGlob(Names + Entry.NameOffset, Entry.NameLength, Pattern))
+				Results.emplace_back(i);
+		}
+
+		// Done
+		return true;
+	}
+	case IFSCatalogQuery::Regex:
+	{
+		try
+		{
+			// Compile it once
+			std::regex Expression(Pattern, std::regex::ECMAScript | std::regex::icase | std::regex::optimize);
+
+			// Match each name in place
+			for (size_t i = 0; i < this->Entries.size(); i++)
+			{
+				// Grab the entry
+				auto& Entry = this->Entries[i];
+				// Check it
+				if (std::regex_search(Names + Entry.NameOffset, Names + Entry.NameOffset + Entry.NameLength, Expression))
+					Results.emplace_back(i);
+			}
+		}
+		catch (const std::regex_error&)
+		{
+			// Invalid pattern
+			Results.clear();
+			return false;
+		}
+
+		// Done
+		return true;
+	}
+	}
+
+	// Unknown query
+	return false;
+}
+
+void IFSCatalog::GetTotals(const std::vector<size_t>& Entries, uint64_t& CompressedSize, uint64_t& FileSize) const
+{
+	// Reset
+	CompressedSize = 0;
+	FileSize = 0;
+
+	// Sum them
+	for (auto Index : Entries)
+	{
+		CompressedSize += this->Entries[Index].CompressedSize;
+		FileSize += this->Entries[Index].FileSize;
+	}
+}
+
+bool IFSCatalog::ExportCSV(const std::string& FilePath, const std::vector<size_t>& Entries) const
+{
+	// Build the file, starting with the header
+	std::string Output = "name,package,offset,compressed_size,size,flags\n";
+	// Iterate
+	for (auto Index : Entries)
+	{
+		// Grab the entry
+		auto& Entry = this->Entries[Index];
+		auto PackageName = FileSystems::GetFileName(this->Packages[Entry.PackageIndex]);
+
+		// Write the names
+		AppendCatalogCSV(Output, this->NameTable.data() + Entry.NameOffset, Entry.NameLength);
+		Output += ',';
+		AppendCatalogCSV(Output, PackageName.c_str(), PackageName.size());
+
+		// Write the numbers
+		Output += Strings::Format(",%llu,%u,%u,0x%08X\n", Entry.FilePosition, Entry.CompressedSize, Entry.FileSize, Entry.Flags);
+	}
+
+	// Write it
+	return WriteCatalogFile(FilePath, Output);
+}
+
+bool IFSCatalog::ExportJSON(const std::string& FilePath, const std::vector<size_t>& Entries) const
+{
+	// Build the file
+	std::string Output = "[\n";
+	// Iterate
+	for (size_t i = 0; i < Entries.size(); i++)
+	{
+		// Grab the entry
+		auto& Entry = this->Entries[Entries[i]];
+		auto PackageName = FileSystems::GetFileName(this->Packages[Entry.PackageIndex]);
+
+		// Write the names
+		Output += "\t{ \"name\": ";
+		AppendCatalogJSON(Output, this->NameTable.data() + Entry.NameOffset, Entry.NameLength);
+		Output += ", \"package\": ";
+		AppendCatalogJSON(Output, PackageName.c_str(), PackageName.size());
+
+		// Write the numbers
+		Output += Strings::Format(", \"offset\": %llu, \"compressed_size\": %u, \"size\": %u, \"flags\": %u }%s\n", Entry.FilePosition, Entry.CompressedSize, Entry.FileSize, Entry.Flags, (i + 1 < Entries.size()) ? "," : "");
+	}
+
+	// Close it
+	Output += "]\n";
+
+	// Write it
+	return WriteCatalogFile(FilePath, Output);
+}
+
+void IFSCatalog::FindPrefixRange(const std::string& Prefix, size_t& Begin, size_t& End) const
+{
+	// Grab the names
+	auto Names = this->NameTable.data();
+	auto PrefixData = Prefix.c_str();
+	auto PrefixLength = Prefix.size();
+
+	// Find the first name not before the prefix
+	auto First = std::lower_bound(this->Entries.begin(), this->Entries.end(), 0, [Names, PrefixData, PrefixLength](const IFSCatalogEntry& Entry, int)
+	{
+		return CompareCatalogNames(Names + Entry.NameOffset, Entry.NameLength, PrefixData, PrefixLength) < 0;
+	});
+
+	// Find the first name past the prefix, comparing only as far as the prefix goes
+	auto Last = std::lower_bound(First, this->Entries.end(), 0, [Names, PrefixData, PrefixLength](const IFSCatalogEntry& Entry, int)
+	{
+		// Compare the start of the name
+		auto Length = (Entry.NameLength < PrefixLength) ? (size_t)Entry.NameLength : PrefixLength;
+		// It's within the range while it starts with the prefix
+		return CompareCatalogNames(Names + Entry.NameOffset, Length, PrefixData, PrefixLength) <= 0 && Length == PrefixLength;
+	});
+
+	// Assign
+	Begin = (size_t)(First - this->Entries.begin());
+	End = (size_t)(Last - this->Entries.begin());
+}
\ No newline at end of file
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// We need the file entry
+#include "IFSFileTable.h"
+
+// An entry in the catalog, the name lives in the catalog's name table
+struct IFSCatalogEntry
+{
+	// The name, as an offset and length into the name table
+	uint32_t NameOffset;
+	uint32_t NameLength;
+
+	// The package holding the entry
+	uint32_t PackageIndex;
+	// The entry flags
+	uint32_t Flags;
+
+	// The position of the entry in the package
+	uint64_t FilePosition;
+	// The unpacked size
+	uint32_t FileSize;
+	// The packed size, as stored
+	uint32_t CompressedSize;
+};
+
+// The types of catalog queries, all of them ignore case, and treat both slashes the same
+enum class IFSCatalogQuery
+{
+	// Names starting with the pattern
+	Prefix,
+	// Names matching the pattern, with * and ? wildcards
+	Glob,
+	// Names containing a match of the pattern, an ECMAScript regular expression
+	Regex
+};
+
+// A class that lists the entries of mounted packages by name, without decoding any of them
+class IFSCatalog
+{
+public:
+	// Constructors
+	IFSCatalog();
+	~IFSCatalog();
+
+	// Adds a package, returns its index in the catalog
+	uint32_t AddPackage(const std::string& PackagePath);
+	// Adds an entry, the name is copied into the name table
+	void AddEntry(const char* Name, size_t NameLength, uint32_t PackageIndex, const IFSFileEntry& Entry);
+	// Counts an entry that was left out, as it isn't downloaded yet
+	void AddAbsent(const IFSFileEntry& Entry);
+	// Sorts the entries by name, must be called once everything is added, before querying
+	void Finalize();
+	// Removes everything
+	void Clear();
+
+	// Gets the count of entries
+	size_t GetCount() const;
+	// Gets an entry
+	const IFSCatalogEntry& GetEntry(size_t Index) const;
+	// Gets the name of an entry
+	std::string GetName(size_t Index) const;
+	// Gets the path of a package
+	const std::string& GetPackagePath(uint32_t PackageIndex) const;
+	// Gets the count of entries left out, as they aren't downloaded yet
+	uint64_t GetAbsentCount() const;
+	// Gets the packed size of the entries left out
+	uint64_t GetAbsentSize() const;
+
+	// Finds the entries matching a query, in name order, returns false if the pattern is invalid
+	bool Query(IFSCatalogQuery Type, const std::string& Pattern, std::vector<size_t>& Results) const;
+	// Sums the sizes of a set of entries
+	void GetTotals(const std::vector<size_t>& Entries, uint64_t& CompressedSize, uint64_t& FileSize) const;
+
+	// Writes a set of entries to a CSV file
+	bool ExportCSV(const std::string& FilePath, const std::vector<size_t>& Entries) const;
+	// Writes a set of entries to a JSON file
+	bool ExportJSON(const std::string& FilePath, const std::vector<size_t>& Entries) const;
+
+private:
+	// The names, back to back, without terminators
+	std::vector<char> NameTable;
+	// The entries, sorted by name once finalized
+	std::vector<IFSCatalogEntry> Entries;
+	// The package paths
+	std::vector<std::string> Packages;
+
+	// The entries left out, and their packed size
+	uint64_t AbsentCount;
+	uint64_t AbsentSize;
+
+	// Finds the range of entries starting with the prefix
+	void FindPrefixRange(const std::string& Prefix, size_t& Begin, size_t& End) const;
+
+	// Prevent copies, the tables can be large
+	IFSCatalog(const IFSCatalog&);
+	IFSCatalog& operator=(const IFSCatalog&);
+};
\ No newline at end of file
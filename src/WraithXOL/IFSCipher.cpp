@@ -0,0 +1,269 @@
+#include "stdafx.h"
+
+// The class we are implementing
+#include "IFSCipher.h"
+
+// We need the cpuid and AES-NI intrinsics
+#include <intrin.h>
+#include <wmmintrin.h>
+
+// The count of counter blocks kept in flight
+#define IFS_CIPHER_LANES 8
+
+// The AES forward s-box, used to expand the key
+const uint8_t IFSAesSBox[256] =
+{
+	0x63, 0x7c, 0x77, 0x7b, 0xf2, 0x6b, 0x6f, 0xc5, 0x30, 0x01, 0x67, 0x2b, 0xfe, 0xd7, 0xab, 0x76,
+	0xca, 0x82, 0xc9, 0x7d, 0xfa, 0x59, 0x47, 0xf0, 0xad, 0xd4, 0xa2, 0xaf, 0x9c, 0xa4, 0x72, 0xc0,
+	0xb7, 0xfd, 0x93, 0x26, 0x36, 0x3f, 0xf7, 0xcc, 0x34, 0xa5, 0xe5, 0xf1, 0x71, 0xd8, 0x31, 0x15,
+	0x04, 0xc7, 0x23, 0xc3, 0x18, 0x96, 0x05, 0x9a, 0x07, 0x12, 0x80, 0xe2, 0xeb, 0x27, 0xb2, 0x75,
+	0x09, 0x83, 0x2c, 0x1a, 0x1b, 0x6e, 0x5a, 0xa0, 0x52, 0x3b, 0xd6, 0xb3, 0x29, 0xe3, 0x2f, 0x84,
+	0x53, 0xd1, 0x00, 0xed, 0x20, 0xfc, 0xb1, 0x5b, 0x6a, 0xcb, 0xbe, 0x39, 0x4a, 0x4c, 0x58, 0xcf,
+	0xd0, 0xef, 0xaa, 0xfb, 0x43, 0x4d, 0x33, 0x85, 0x45, 0xf9, 0x02, 0x7f, 0x50, 0x3c, 0x9f, 0xa8,
+	0x51, 0xa3, 0x40, 0x8f, 0x92, 0x9d, 0x38, 0xf5, 0xbc, 0xb6, 0xda, 0x21, 0x10, 0xff, 0xf3, 0xd2,
+	0xcd, 0x0c, 0x13, 0xec, 0x5f, 0x97, 0x44, 0x17, 0xc4, 0xa7, 0x7e, 0x3d, 0x64, 0x5d, 0x19, 0x73,
+	0x60, 0x81, 0x4f, 0xdc, 0x22, 0x2a, 0x90, 0x88, 0x46, 0xee, 0xb8, 0x14, 0xde, 0x5e, 0x0b, 0xdb,
+	0xe0, 0x32, 0x3a, 0x0a, 0x49, 0x06, 0x24, 0x5c, 0xc2, 0xd3, 0xac, 0x62, 0x91, 0x95, 0xe4, 0x79,
+	0xe7, 0xc8, 0x37, 0x6d, 0x8d, 0xd5, 0x4e, 0xa9, 0x6c, 0x56, 0xf4, 0xea, 0x65, 0x7a, 0xae, 0x08,
+	0xba, 0x78, 0x25, 0x2e, 0x1c, 0xa6, 0xb4, 0xc6, 0xe8, 0xdd, 0x74, 0x1f, 0x4b, 0xbd, 0x8b, 0x8a,
+	0x70, 0x3e, 0xb5, 0x66, 0x48, 0x03, 0xf6, 0x0e, 0x61, 0x35, 0x57, 0xb9, 0x86, 0xc1, 0x1d, 0x9e,
+	0xe1, 0xf8, 0x98, 0x11, 0x69, 0xd9, 0x8e, 0x94, 0x9b, 0x1e, 0x87, 0xe9, 0xce, 0x55, 0x28, 0xdf,
+	0x8c, 0xa1, 0x89, 0x0d, 0xbf, 0xe6, 0x42, 0x68, 0x41, 0x99, 0x2d, 0x0f, 0xb0, 0x54, 0xbb, 0x16
+};
+
+// Expands an AES key into round keys, in the byte order AES-NI expects
+void ExpandIFSAesKey(const uint8_t* Key, uint32_t KeySize, uint8_t* RoundKeys, uint32_t& RoundCount)
+{
+	// Calculate the schedule size
+	auto KeyWords = KeySize / 4;
+	auto TotalWords = 4 * (KeyWords + 7);
+	// Set the round count
+	RoundCount = KeyWords + 6;
+
+	// The first round keys are the key itself
+	std::memcpy(RoundKeys, Key, KeySize);
+
+	// The round constant
+	uint8_t RoundConstant = 1;
+
+	// Build the rest
+	for (uint32_t i = KeyWords; i < TotalWords; i++)
+	{
+		// Grab the previous word
+		uint8_t Temp[4];
+		std::memcpy(Temp, RoundKeys + (i - 1) * 4, 4);
+
+		// Rotate, substitute, and mix in the constant at the start of each key
+		if ((i % KeyWords) == 0)
+		{
+			auto First = Temp[0];
+			Temp[0] = IFSAesSBox[Temp[1]] ^ RoundConstant;
+			Temp[1] = IFSAesSBox[Temp[2]];
+			Temp[2] = IFSAesSBox[Temp[3]];
+			Temp[3] = IFSAesSBox[First];
+
+			// Advance the constant
+			RoundConstant = (uint8_t)((RoundConstant << 1) ^ ((RoundConstant & 0x80) ? 0x1B : 0));
+		}
+		else if (KeyWords > 6 && (i % KeyWords) == 4)
+		{
+			// AES-256 substitutes halfway through each key
+			for (uint32_t j = 0; j < 4; j++)
+				Temp[j] = IFSAesSBox[Temp[j]];
+		}
+
+		// Assign it
+		for (uint32_t j = 0; j < 4; j++)
+			RoundKeys[i * 4 + j] = RoundKeys[(i - KeyWords) * 4 + j] ^ Temp[j];
+	}
+}
+
+// Builds a counter block from the big-endian halves of a 128bit counter
+inline __m128i BuildIFSCounterBlock(uint64_t CounterHigh, uint64_t CounterLow)
+{
+	// Store each half big-endian, built in registers so it's never reloaded from memory
+	return _mm_set_epi32((int)_byteswap_ulong((uint32_t)CounterLow), (int)_byteswap_ulong((uint32_t)(CounterLow >> 32)), (int)_byteswap_ulong((uint32_t)CounterHigh), (int)_byteswap_ulong((uint32_t)(CounterHigh >> 32)));
+}
+
+// Runs an AES round across every lane, written out so the lanes stay in registers and pipeline
+inline void IFSAesRoundLanes(__m128i* States, const __m128i& Key)
+{
+	States[0] = _mm_aesenc_si128(States[0], Key);
+	States[1] = _mm_aesenc_si128(States[1], Key);
+	States[2] = _mm_aesenc_si128(States[2], Key);
+	States[3] = _mm_aesenc_si128(States[3], Key);
+	States[4] = _mm_aesenc_si128(States[4], Key);
+	States[5] = _mm_aesenc_si128(States[5], Key);
+	States[6] = _mm_aesenc_si128(States[6], Key);
+	States[7] = _mm_aesenc_si128(States[7], Key);
+}
+
+// Runs the final AES round across every lane
+inline void IFSAesLastRoundLanes(__m128i* States, const __m128i& Key)
+{
+	States[0] = _mm_aesenclast_si128(States[0], Key);
+	States[1] = _mm_aesenclast_si128(States[1], Key);
+	States[2] = _mm_aesenclast_si128(States[2], Key);
+	States[3] = _mm_aesenclast_si128(States[3], Key);
+	States[4] = _mm_aesenclast_si128(States[4], Key);
+	States[5] = _mm_aesenclast_si128(States[5], Key);
+	States[6] = _mm_aesenclast_si128(States[6], Key);
+	States[7] = _mm_aesenclast_si128(States[7], Key);
+}
+
+IFSCipher::IFSCipher(const uint8_t* Key, uint32_t KeySize)
+{
+	// Schedule the software key, the IV is set per run
+	uint8_t DefaultIV[16] = { 0 };
+	// Start it
+	ctr_start(find_cipher("aes"), &DefaultIV[0], Key, (int)KeySize, 0, CTR_COUNTER_BIG_ENDIAN, &this->SoftwareKey);
+
+	// Expand the AES-NI key
+	std::memset(this->RoundKeys, 0, sizeof(this->RoundKeys));
+	ExpandIFSAesKey(Key, KeySize, this->RoundKeys, this->RoundCount);
+
+	// Check for AES-NI support
+	int CpuInfo[4];
+	// Fetch features
+	__cpuid(CpuInfo, 1);
+
+	// Use it if present, and it produces the same keystream as libtomcrypt
+	this->Accelerated = ((CpuInfo[2] & (1 << 25)) != 0);
+	// Verify it
+	if (this->Accelerated)
+		this->Accelerated = this->VerifyAccelerated();
+}
+
+IFSCipher::~IFSCipher()
+{
+	// Clean up
+	ctr_done(&this->SoftwareKey);
+}
+
+void IFSCipher::DecryptCTR(const uint8_t* IV, const uint8_t* Input, uint8_t* Output, uint32_t Size) const
+{
+	// Pick the engine
+	if (this->Accelerated)
+		this->DecryptCTRAccelerated(IV, Input, Output, Size);
+	else
+		this->DecryptCTRSoftware(IV, Input, Output, Size);
+}
+
+bool IFSCipher::IsAccelerated() const
+{
+	return this->Accelerated;
+}
+
+void IFSCipher::DecryptCTRAccelerated(const uint8_t* IV, const uint8_t* Input, uint8_t* Output, uint32_t Size) const
+{
+	// Load the round keys
+	__m128i Keys[15];
+	// Iterate
+	for (uint32_t i = 0; i <= this->RoundCount; i++)
+		Keys[i] = _mm_loadu_si128((const __m128i*)(this->RoundKeys + i * 16));
+
+	// The current counter, as big-endian halves
+	uint64_t CounterHigh = 0, CounterLow = 0;
+	// Load them
+	std::memcpy(&CounterHigh, IV, 8);
+	std::memcpy(&CounterLow, IV + 8, 8);
+	// Swap them
+	CounterHigh = _byteswap_uint64(CounterHigh);
+	CounterLow = _byteswap_uint64(CounterLow);
+
+	// The keystream
+	__m128i States[IFS_CIPHER_LANES];
+
+	// Full runs, every lane is independent so the rounds pipeline
+	while (Size >= (IFS_CIPHER_LANES * 16))
+	{
+		// Build the counters, and whiten
+		for (uint32_t i = 0; i < IFS_CIPHER_LANES; i++)
+		{
+			States[i] = _mm_xor_si128(BuildIFSCounterBlock(CounterHigh, CounterLow), Keys[0]);
+
+			// Advance, carrying into the high half
+			if (++CounterLow == 0)
+				CounterHigh++;
+		}
+
+		// Rounds
+		for (uint32_t r = 1; r < this->RoundCount; r++)
+			IFSAesRoundLanes(States, Keys[r]);
+		// Final round
+		IFSAesLastRoundLanes(States, Keys[this->RoundCount]);
+
+		// Apply the keystream
+		for (uint32_t i = 0; i < IFS_CIPHER_LANES; i++)
+			_mm_storeu_si128((__m128i*)(Output + i * 16), _mm_xor_si128(_mm_loadu_si128((const __m128i*)(Input + i * 16)), States[i]));
+
+		// Advance
+		Input += IFS_CIPHER_LANES * 16;
+		Output += IFS_CIPHER_LANES * 16;
+		Size -= IFS_CIPHER_LANES * 16;
+	}
+
+	// The tail, less than a full run
+	uint8_t Keystream[16];
+
+	// Encrypt each counter block
+	while (Size > 0)
+	{
+		// Whiten
+		auto State = _mm_xor_si128(BuildIFSCounterBlock(CounterHigh, CounterLow), Keys[0]);
+		// Rounds
+		for (uint32_t r = 1; r < this->RoundCount; r++)
+			State = _mm_aesenc_si128(State, Keys[r]);
+		// Final round, store the keystream
+		_mm_storeu_si128((__m128i*)Keystream, _mm_aesenclast_si128(State, Keys[this->RoundCount]));
+
+		// Apply the keystream
+		auto BlockSize = (Size > 16) ? 16 : Size;
+		// Iterate
+		for (uint32_t i = 0; i < BlockSize; i++)
+			Output[i] = Input[i] ^ Keystream[i];
+
+		// Advance, carrying into the high half
+		if (++CounterLow == 0)
+			CounterHigh++;
+
+		// Advance
+		Input += BlockSize;
+		Output += BlockSize;
+		Size -= BlockSize;
+	}
+}
+
+void IFSCipher::DecryptCTRSoftware(const uint8_t* IV, const uint8_t* Input, uint8_t* Output, uint32_t Size) const
+{
+	// Clone the scheduled key, the IV is set per run
+	symmetric_CTR RunKey = this->SoftwareKey;
+
+	// Set the IV
+	ctr_setiv(IV, 0x10, &RunKey);
+	// Decrypt
+	ctr_decrypt(Input, Output, Size, &RunKey);
+}
+
+bool IFSCipher::VerifyAccelerated() const
+{
+	// Covers full runs, the tail, a partial block, and a carry across the counter bytes
+	uint8_t TestIV[16] = { 0x78, 0x56, 0x34, 0x12, 0x00, 0x80, 0x00, 0x00, 0xFC, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFA };
+	// The test sizes
+	const uint32_t TestSize = (IFS_CIPHER_LANES * 16 * 2) + 0x35;
+
+	// Build the input
+	uint8_t TestInput[TestSize];
+	// Fill it
+	for (uint32_t i = 0; i < TestSize; i++)
+		TestInput[i] = (uint8_t)((i * 0x9D) ^ 0x5A);
+
+	// Run both engines
+	uint8_t SoftwareOutput[TestSize], AcceleratedOutput[TestSize];
+	// Decrypt
+	this->DecryptCTRSoftware(TestIV, TestInput, SoftwareOutput, TestSize);
+	this->DecryptCTRAccelerated(TestIV, TestInput, AcceleratedOutput, TestSize);
+
+	// They must match exactly
+	return (std::memcmp(SoftwareOutput, AcceleratedOutput, TestSize) == 0);
+}
\ No newline at end of file
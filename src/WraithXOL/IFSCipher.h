@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+
+// Configure LibTom
+#define LTM_DESC
+
+// Encryption
+#include "tomcrypt.h"
+
+// A class that decrypts AES-CTR runs with a big-endian counter, using AES-NI when available
+class IFSCipher
+{
+public:
+	// Constructors (Key is 16, 24 or 32 bytes, libtomcrypt's aes must be registered)
+	IFSCipher(const uint8_t* Key, uint32_t KeySize);
+	~IFSCipher();
+
+	// Decrypts a run, the keystream starts at IV, and counts up from there, safe to call from multiple threads
+	void DecryptCTR(const uint8_t* IV, const uint8_t* Input, uint8_t* Output, uint32_t Size) const;
+
+	// Whether or not AES-NI is being used
+	bool IsAccelerated() const;
+
+private:
+	// The scheduled libtomcrypt key, used when AES-NI is not available
+	symmetric_CTR SoftwareKey;
+
+	// The expanded round keys for AES-NI
+	uint8_t RoundKeys[15 * 16];
+	// The count of rounds
+	uint32_t RoundCount;
+
+	// Whether or not AES-NI is being used
+	bool Accelerated;
+
+	// Decrypts a run with AES-NI
+	void DecryptCTRAccelerated(const uint8_t* IV, const uint8_t* Input, uint8_t* Output, uint32_t Size) const;
+	// Decrypts a run with libtomcrypt
+	void DecryptCTRSoftware(const uint8_t* IV, const uint8_t* Input, uint8_t* Output, uint32_t Size) const;
+
+	// Checks the AES-NI engine against libtomcrypt
+	bool VerifyAccelerated() const;
+
+	// Prevent copies, we own the cipher state
+	IFSCipher(const IFSCipher&);
+	IFSCipher& operator=(const IFSCipher&);
+};
\ No newline at end of file
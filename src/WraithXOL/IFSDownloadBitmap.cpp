@@ -0,0 +1,78 @@
+#include "stdafx.h"
+
+// The class we are implementing
+#include "IFSDownloadBitmap.h"
+
+IFSDownloadBitmap::IFSDownloadBitmap()
+{
+	// Defaults
+	this->PieceSize = 0;
+	this->PieceCount = 0;
+	this->PresentPieces = 0;
+}
+
+IFSDownloadBitmap::~IFSDownloadBitmap()
+{
+	// Default
+}
+
+void IFSDownloadBitmap::Load(const uint8_t* Bitmap, uint64_t BitmapSize, uint32_t PieceSize, uint64_t PieceCount)
+{
+	// Copy it, the downloader may update it while we're mounted
+	this->Bits.assign(Bitmap, Bitmap + BitmapSize);
+	this->PieceSize = PieceSize;
+	this->PieceCount = PieceCount;
+
+	// Count what we have
+	this->PresentPieces = 0;
+	// Iterate
+	for (uint64_t i = 0; i < PieceCount && (i / 8) < BitmapSize; i++)
+	{
+		if (this->Bits[(size_t)(i / 8)] & (1 << (i % 8)))
+			this->PresentPieces++;
+	}
+}
+
+bool IFSDownloadBitmap::IsComplete() const
+{
+	return (this->PresentPieces == this->PieceCount);
+}
+
+bool IFSDownloadBitmap::IsRangePresent(uint64_t Offset, uint64_t Size) const
+{
+	// Everything is there
+	if (this->IsComplete())
+		return true;
+	// Nothing to check
+	if (this->PieceSize == 0 || Size == 0)
+		return true;
+
+	// Find the pieces
+	auto FirstPiece = Offset / this->PieceSize;
+	auto LastPiece = (Offset + Size - 1) / this->PieceSize;
+
+	// Check each one
+	for (auto Piece = FirstPiece; Piece <= LastPiece; Piece++)
+	{
+		// Past the end of the bitmap
+		if (Piece >= this->PieceCount || (Piece / 8) >= this->Bits.size())
+			return false;
+
+		// Missing
+		if ((this->Bits[(size_t)(Piece / 8)] & (1 << (Piece % 8))) == 0)
+			return false;
+	}
+
+	// All there
+	return true;
+}
+
+uint64_t IFSDownloadBitmap::GetPieceCount() const
+{
+	return this->PieceCount;
+}
+
+uint64_t IFSDownloadBitmap::GetPresentPieces() const
+{
+	return this->PresentPieces;
+}
\ No newline at end of file
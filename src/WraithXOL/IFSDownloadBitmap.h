@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// A class that tracks which pieces of a partially downloaded package are on disk, one bit per piece, lowest bit first
+class IFSDownloadBitmap
+{
+public:
+	// Constructors
+	IFSDownloadBitmap();
+	~IFSDownloadBitmap();
+
+	// Loads a copy of the bitmap, pieces past the end of it are treated as missing
+	void Load(const uint8_t* Bitmap, uint64_t BitmapSize, uint32_t PieceSize, uint64_t PieceCount);
+
+	// Whether or not every piece is on disk
+	bool IsComplete() const;
+	// Whether or not every piece backing the range is on disk
+	bool IsRangePresent(uint64_t Offset, uint64_t Size) const;
+
+	// Gets the count of pieces
+	uint64_t GetPieceCount() const;
+	// Gets the count of pieces on disk
+	uint64_t GetPresentPieces() const;
+
+private:
+	// The bits
+	std::vector<uint8_t> Bits;
+	// The size of each piece
+	uint32_t PieceSize;
+	// The count of pieces
+	uint64_t PieceCount;
+	// The count of pieces on disk
+	uint64_t PresentPieces;
+};
\ No newline at end of file
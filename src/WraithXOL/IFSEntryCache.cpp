@@ -0,0 +1,154 @@
+#include "stdafx.h"
+
+// The class we are implementing
+#include "IFSEntryCache.h"
+
+// The largest share of the budget a single entry may take
+#define IFS_ENTRY_CACHE_MAX_SHARE 8
+
+IFSEntryCache::IFSEntryCache(uint64_t Budget)
+{
+	// Defaults
+	this->Budget = Budget;
+	this->CachedBytes = 0;
+	this->Hits = 0;
+	this->Misses = 0;
+	this->Evictions = 0;
+}
+
+IFSEntryCache::~IFSEntryCache()
+{
+	// Default
+}
+
+void IFSEntryCache::SetBudget(uint64_t Budget)
+{
+	std::lock_guard<std::mutex> Lock(this->CacheMutex);
+	// Set it
+	this->Budget = Budget;
+	// Shrink to fit
+	this->EvictToBudget();
+}
+
+uint64_t IFSEntryCache::GetBudget() const
+{
+	std::lock_guard<std::mutex> Lock(this->CacheMutex);
+	// Fetch it
+	return this->Budget;
+}
+
+bool IFSEntryCache::CanCache(uint64_t DataSize) const
+{
+	std::lock_guard<std::mutex> Lock(this->CacheMutex);
+	// Check it
+	return (this->Budget > 0 && DataSize > 0 && DataSize <= (this->Budget / IFS_ENTRY_CACHE_MAX_SHARE));
+}
+
+bool IFSEntryCache::Find(uint64_t EntryHash, std::shared_ptr<const IFSCachedEntry>& Result)
+{
+	std::lock_guard<std::mutex> Lock(this->CacheMutex);
+	// Nothing is counted while we're off
+	if (this->Budget == 0)
+		return false;
+
+	// Find it
+	auto Node = this->Entries.find(EntryHash);
+	// Check it
+	if (Node == this->Entries.end())
+	{
+		// Count it
+		this->Misses++;
+		return false;
+	}
+
+	// Move it to the front
+	this->UseOrder.splice(this->UseOrder.begin(), this->UseOrder, Node->second.UsePosition);
+
+	// Count it
+	this->Hits++;
+
+	// Share it
+	Result = Node->second.Entry;
+	return true;
+}
+
+void IFSEntryCache::Insert(uint64_t EntryHash, const uint8_t* Data, uint32_t DataSize)
+{
+	// Check that it's worth keeping
+	if (Data == nullptr || !this->CanCache(DataSize))
+		return;
+
+	// Copy it before locking, this is the slow part
+	auto Entry = std::make_shared<IFSCachedEntry>();
+	// Assign
+	Entry->Data = std::make_unique<uint8_t[]>(DataSize);
+	Entry->DataSize = DataSize;
+	// Copy
+	std::memcpy(Entry->Data.get(), Data, DataSize);
+
+	std::lock_guard<std::mutex> Lock(this->CacheMutex);
+	// Another reader may have added it first, or the budget may have changed
+	if (this->Budget == 0 || this->Entries.find(EntryHash) != this->Entries.end())
+		return;
+
+	// Add it to the front
+	this->UseOrder.push_front(EntryHash);
+
+	// Setup the node
+	IFSCacheNode Node;
+	// Assign
+	Node.Entry = Entry;
+	Node.UsePosition = this->UseOrder.begin();
+
+	// Add it
+	this->Entries.emplace(EntryHash, Node);
+	this->CachedBytes += DataSize;
+
+	// Make room
+	this->EvictToBudget();
+}
+
+void IFSEntryCache::Clear()
+{
+	std::lock_guard<std::mutex> Lock(this->CacheMutex);
+	// Drop everything, readers still holding an entry keep it alive
+	this->Entries.clear();
+	this->UseOrder.clear();
+	this->CachedBytes = 0;
+}
+
+IFSEntryCacheStats IFSEntryCache::GetStatistics() const
+{
+	std::lock_guard<std::mutex> Lock(this->CacheMutex);
+
+	// Copy them
+	IFSEntryCacheStats Result;
+	// Assign
+	Result.Hits = this->Hits;
+	Result.Misses = this->Misses;
+	Result.Evictions = this->Evictions;
+	Result.CachedEntries = this->Entries.size();
+	Result.CachedBytes = this->CachedBytes;
+	Result.Budget = this->Budget;
+
+	// Done
+	return Result;
+}
+
+void IFSEntryCache::EvictToBudget()
+{
+	// Drop from the back, the least recently used
+	while (this->CachedBytes > this->Budget && !this->UseOrder.empty())
+	{
+		// Find it
+		auto Node = this->Entries.find(this->UseOrder.back());
+
+		// Release it
+		this->CachedBytes -= Node->second.Entry->DataSize;
+		this->Entries.erase(Node);
+		this->UseOrder.pop_back();
+
+		// Count it
+		this->Evictions++;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+// A decoded entry held by the cache, shared with readers so it can be evicted while they copy it out
+struct IFSCachedEntry
+{
+	// The decoded data
+	std::unique_ptr<uint8_t[]> Data;
+	// The size of the data
+	uint32_t DataSize;
+};
+
+// The counters of an entry cache
+struct IFSEntryCacheStats
+{
+	// Lookups that found the entry
+	uint64_t Hits;
+	// Lookups that didn't
+	uint64_t Misses;
+	// Entries dropped to stay in budget
+	uint64_t Evictions;
+	// The entries held right now
+	uint64_t CachedEntries;
+	// The bytes held right now
+	uint64_t CachedBytes;
+	// The most bytes held at once
+	uint64_t Budget;
+};
+
+// A class that keeps recently decoded entries, up to a byte budget, dropping the least recently used first, safe to use from multiple threads
+class IFSEntryCache
+{
+public:
+	// Constructors (A budget of 0 turns the cache off)
+	IFSEntryCache(uint64_t Budget = 0);
+	~IFSEntryCache();
+
+	// Sets the byte budget, dropping entries until they fit, 0 turns the cache off
+	void SetBudget(uint64_t Budget);
+	// Gets the byte budget
+	uint64_t GetBudget() const;
+	// Whether or not an entry of this size would be kept, large entries would push out too many others
+	bool CanCache(uint64_t DataSize) const;
+
+	// Finds an entry, marking it as the most recently used
+	bool Find(uint64_t EntryHash, std::shared_ptr<const IFSCachedEntry>& Result);
+	// Adds a copy of a decoded entry, if it fits
+	void Insert(uint64_t EntryHash, const uint8_t* Data, uint32_t DataSize);
+	// Drops all entries, the counters are kept
+	void Clear();
+
+	// Gets the counters
+	IFSEntryCacheStats GetStatistics() const;
+
+private:
+	// A cached entry, and where it sits in the use order
+	struct IFSCacheNode
+	{
+		std::shared_ptr<const IFSCachedEntry> Entry;
+		std::list<uint64_t>::iterator UsePosition;
+	};
+
+	// The cached entries
+	std::unordered_map<uint64_t, IFSCacheNode> Entries;
+	// The entry hashes, most recently used first
+	std::list<uint64_t> UseOrder;
+
+	// The byte budget
+	uint64_t Budget;
+	// The bytes held
+	uint64_t CachedBytes;
+
+	// The counters
+	uint64_t Hits;
+	uint64_t Misses;
+	uint64_t Evictions;
+
+	// Guards everything above
+	mutable std::mutex CacheMutex;
+
+	// Drops the least recently used entries until we're in budget (CacheMutex must be held)
+	void EvictToBudget();
+
+	// Prevent copies
+	IFSEntryCache(const IFSEntryCache&);
+	IFSEntryCache& operator=(const IFSEntryCache&);
+};
\ No newline at end of file
@@ -0,0 +1,110 @@
+#include "stdafx.h"
+
+// The class we are implementing
+#include "IFSEntrySink.h"
+
+IFSBufferSink::IFSBufferSink()
+{
+	// Defaults
+	this->BufferSize = 0;
+	this->BufferPosition = 0;
+}
+
+IFSBufferSink::~IFSBufferSink()
+{
+	// Default
+}
+
+bool IFSBufferSink::Begin(uint32_t UnpackedSize)
+{
+	// Allocate the result buffer
+	this->Buffer = std::make_unique<uint8_t[]>(UnpackedSize);
+	this->BufferSize = UnpackedSize;
+	this->BufferPosition = 0;
+
+	// Success
+	return true;
+}
+
+bool IFSBufferSink::Write(const uint8_t* Data, uint32_t Size)
+{
+	// Verify it fits
+	if (Size > (this->BufferSize - this->BufferPosition))
+		return false;
+
+	// Copy it
+	std::memcpy(this->Buffer.get() + this->BufferPosition, Data, Size);
+	// Advance
+	this->BufferPosition += Size;
+
+	// Success
+	return true;
+}
+
+uint8_t* IFSBufferSink::GetDirectBuffer()
+{
+	return this->Buffer.get();
+}
+
+std::unique_ptr<uint8_t[]> IFSBufferSink::TakeBuffer(uint32_t& ResultSize)
+{
+	// Set the size
+	ResultSize = this->BufferSize;
+
+	// Reset
+	this->BufferSize = 0;
+	this->BufferPosition = 0;
+
+	// Return it
+	return std::move(this->Buffer);
+}
+
+IFSFileSink::IFSFileSink(const std::string& FilePath)
+{
+	// Defaults
+	this->FilePath = FilePath;
+	this->Created = false;
+}
+
+IFSFileSink::~IFSFileSink()
+{
+	// Default, the writer closes the file
+}
+
+bool IFSFileSink::Begin(uint32_t UnpackedSize)
+{
+	// Create the file, only now that we know the entry exists, the writer throws if the file is in use
+	try
+	{
+		this->Created = this->Writer.Create(this->FilePath);
+	}
+	catch (...)
+	{
+		// Abort the stream
+		this->Created = false;
+	}
+
+	// Return result
+	return this->Created;
+}
+
+bool IFSFileSink::Write(const uint8_t* Data, uint32_t Size)
+{
+	// Make sure we're open
+	if (!this->Created)
+		return false;
+
+	// Write it, the writer throws if it can't be written
+	try
+	{
+		this->Writer.Write((int8_t*)Data, Size);
+	}
+	catch (...)
+	{
+		// Abort the stream
+		return false;
+	}
+
+	// Success
+	return true;
+}
\ No newline at end of file
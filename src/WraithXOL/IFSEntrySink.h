@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+// We need the following classes
+#include "BinaryWriter.h"
+
+// Receives the decoded data of an entry as it's streamed out of a package
+class IFSEntrySink
+{
+public:
+	virtual ~IFSEntrySink() { }
+
+	// Called once before any data, with the unpacked size of the entry
+	virtual bool Begin(uint32_t UnpackedSize) = 0;
+	// Called with each decoded piece of the entry, in order
+	virtual bool Write(const uint8_t* Data, uint32_t Size) = 0;
+
+	// Optionally exposes a buffer of the unpacked size to decode straight into, Write is not called when used
+	virtual uint8_t* GetDirectBuffer() { return nullptr; }
+};
+
+// A sink that decodes an entry into a single buffer
+class IFSBufferSink : public IFSEntrySink
+{
+public:
+	// Constructors
+	IFSBufferSink();
+	virtual ~IFSBufferSink();
+
+	virtual bool Begin(uint32_t UnpackedSize);
+	virtual bool Write(const uint8_t* Data, uint32_t Size);
+	virtual uint8_t* GetDirectBuffer();
+
+	// Takes ownership of the decoded buffer
+	std::unique_ptr<uint8_t[]> TakeBuffer(uint32_t& ResultSize);
+
+private:
+	// The decoded buffer
+	std::unique_ptr<uint8_t[]> Buffer;
+	// The size of the buffer
+	uint32_t BufferSize;
+	// The current write position
+	uint32_t BufferPosition;
+};
+
+// A sink that writes an entry straight to a file, without holding it in memory
+class IFSFileSink : public IFSEntrySink
+{
+public:
+	// Constructors
+	IFSFileSink(const std::string& FilePath);
+	virtual ~IFSFileSink();
+
+	virtual bool Begin(uint32_t UnpackedSize);
+	virtual bool Write(const uint8_t* Data, uint32_t Size);
+
+private:
+	// The path of the file
+	std::string FilePath;
+	// The file writer
+	BinaryWriter Writer;
+	// Whether or not the file was created
+	bool Created;
+};
\ No newline at end of file
@@ -0,0 +1,215 @@
+#include "stdafx.h"
+
+// The class we are implementing
+#include "IFSFileTable.h"
+
+// -- Verify structures
+
+static_assert(sizeof(IFSFileSlot) == 0x20, "Invalid IFSFileSlot Size (Expected 0x20)");
+
+// -- End verify
+
+// Clears a run of slots
+void ClearIFSFileSlots(IFSFileSlot* Slots, size_t Count)
+{
+	// Mark each slot empty
+	for (size_t i = 0; i < Count; i++)
+	{
+		std::memset(&Slots[i], 0, sizeof(IFSFileSlot));
+		Slots[i].PackageIndex = IFS_FILE_SLOT_EMPTY;
+	}
+}
+
+IFSFileTable::IFSFileTable()
+{
+	// Defaults
+	this->Capacity = 0;
+	this->Count = 0;
+}
+
+IFSFileTable::~IFSFileTable()
+{
+	// Default
+}
+
+void IFSFileTable::Reserve(size_t Count)
+{
+	// Calculate the capacity, keeping the load under 3/4
+	size_t NewCapacity = 16;
+	// Grow it
+	while ((NewCapacity * 3) / 4 < Count)
+		NewCapacity *= 2;
+
+	// Resize if needed
+	if (NewCapacity > this->Capacity)
+		this->Rehash(NewCapacity);
+}
+
+void IFSFileTable::Clear()
+{
+	// Release the slots
+	this->Slots.reset();
+	this->Capacity = 0;
+	this->Count = 0;
+}
+
+bool IFSFileTable::Insert(uint64_t EntryHash, const IFSFileEntry& Entry, bool Overwrite)
+{
+	// The package index must fit the slot
+	if (Entry.FilePackageIndex >= IFS_FILE_TABLE_MAX_PACKAGES)
+		return false;
+	// So must the sizes and flags, they are never truncated
+	if (Entry.FileSize > 0xFFFFFFFF || Entry.CompressedSize > 0xFFFFFFFF || Entry.Flags > 0xFFFFFFFF)
+		return false;
+
+	// Grow if this entry would pass the max load
+	if (((this->Count + 1) * 4) > (this->Capacity * 3))
+		this->Reserve(this->Count + 1);
+
+	// Probe for the entry, or a free slot
+	auto Mask = this->Capacity - 1;
+	auto Index = (size_t)EntryHash & Mask;
+
+	// Iterate
+	while (this->Slots[Index].PackageIndex != IFS_FILE_SLOT_EMPTY && this->Slots[Index].EntryHash != EntryHash)
+		Index = (Index + 1) & Mask;
+
+	// Grab the slot
+	auto& Slot = this->Slots[Index];
+
+	// Check if it exists
+	if (Slot.PackageIndex != IFS_FILE_SLOT_EMPTY)
+	{
+		// Only replace if asked
+		if (!Overwrite)
+			return false;
+	}
+	else
+	{
+		// New entry
+		this->Count++;
+	}
+
+	// Assign it
+	Slot.EntryHash = EntryHash;
+	Slot.FilePosition = Entry.FilePosition;
+	Slot.FileSize = (uint32_t)Entry.FileSize;
+	Slot.CompressedSize = (uint32_t)Entry.CompressedSize;
+	Slot.Flags = (uint32_t)Entry.Flags;
+	Slot.PackageIndex = (uint16_t)Entry.FilePackageIndex;
+	Slot.Reserved = 0;
+
+	// Stored
+	return true;
+}
+
+bool IFSFileTable::Find(uint64_t EntryHash, IFSFileEntry& Result) const
+{
+	// Find the slot
+	auto Slot = FindSlot(this->Slots.get(), this->Capacity, EntryHash);
+	// Verify
+	if (Slot == nullptr)
+		return false;
+
+	// Found it
+	ReadSlot(*Slot, Result);
+	return true;
+}
+
+size_t IFSFileTable::GetCount() const
+{
+	return this->Count;
+}
+
+size_t IFSFileTable::GetCapacity() const
+{
+	return this->Capacity;
+}
+
+const IFSFileSlot* IFSFileTable::GetSlots() const
+{
+	return this->Slots.get();
+}
+
+size_t IFSFileTable::GetMemoryUsage() const
+{
+	return sizeof(IFSFileTable) + (this->Capacity * sizeof(IFSFileSlot));
+}
+
+void IFSFileTable::LoadSlots(const IFSFileSlot* Slots, size_t Capacity, size_t Count)
+{
+	// Allocate the slots
+	this->Slots = std::make_unique<IFSFileSlot[]>(Capacity);
+	this->Capacity = Capacity;
+	this->Count = Count;
+
+	// Copy them as is, the layout is the same
+	if (Capacity > 0)
+		std::memcpy(this->Slots.get(), Slots, Capacity * sizeof(IFSFileSlot));
+}
+
+const IFSFileSlot* IFSFileTable::FindSlot(const IFSFileSlot* Slots, size_t Capacity, uint64_t EntryHash)
+{
+	// Nothing to search
+	if (Capacity == 0)
+		return nullptr;
+
+	// Probe from the hash, a table we built always has an empty slot, but stored ones are bounded anyway
+	auto Mask = Capacity - 1;
+	auto Index = (size_t)EntryHash & Mask;
+
+	// Iterate
+	for (size_t Probe = 0; Probe < Capacity && Slots[Index].PackageIndex != IFS_FILE_SLOT_EMPTY; Probe++)
+	{
+		// Check it
+		if (Slots[Index].EntryHash == EntryHash)
+			return &Slots[Index];
+
+		// Next slot
+		Index = (Index + 1) & Mask;
+	}
+
+	// Not found
+	return nullptr;
+}
+
+void IFSFileTable::ReadSlot(const IFSFileSlot& Slot, IFSFileEntry& Result)
+{
+	// Widen the entry
+	Result.FilePackageIndex = Slot.PackageIndex;
+	Result.FilePosition = Slot.FilePosition;
+	Result.FileSize = Slot.FileSize;
+	Result.CompressedSize = Slot.CompressedSize;
+	Result.Flags = Slot.Flags;
+}
+
+void IFSFileTable::Rehash(size_t NewCapacity)
+{
+	// Allocate the new slots
+	auto NewSlots = std::make_unique<IFSFileSlot[]>(NewCapacity);
+	// Clear them
+	ClearIFSFileSlots(NewSlots.get(), NewCapacity);
+
+	// Move every entry over
+	auto Mask = NewCapacity - 1;
+	// Iterate
+	for (size_t i = 0; i < this->Capacity; i++)
+	{
+		// Skip empty
+		if (this->Slots[i].PackageIndex == IFS_FILE_SLOT_EMPTY)
+			continue;
+
+		// Probe for a free slot
+		auto Index = (size_t)this->Slots[i].EntryHash & Mask;
+		// Iterate
+		while (NewSlots[Index].PackageIndex != IFS_FILE_SLOT_EMPTY)
+			Index = (Index + 1) & Mask;
+
+		// Move it
+		NewSlots[Index] = this->Slots[i];
+	}
+
+	// Swap them
+	this->Slots = std::move(NewSlots);
+	this->Capacity = NewCapacity;
+}
\ No newline at end of file
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+
+// The package index of an empty slot
+#define IFS_FILE_SLOT_EMPTY 0xFFFF
+// The most packages a table can reference
+#define IFS_FILE_TABLE_MAX_PACKAGES 0xFFFF
+
+// An entry in the IFS package
+struct IFSFileEntry
+{
+	uint32_t FilePackageIndex;
+	uint64_t FilePosition;
+	uint64_t FileSize;
+	uint64_t CompressedSize;
+	uint64_t Flags;
+};
+
+// A packed entry in the file table, two to a cache line, sizes are narrowed to 32 bits as entries are read with 32 bit sizes
+#pragma pack(push, 1)
+struct IFSFileSlot
+{
+	uint64_t EntryHash;
+	uint64_t FilePosition;
+	uint32_t FileSize;
+	uint32_t CompressedSize;
+	uint32_t Flags;
+	uint16_t PackageIndex;
+	uint16_t Reserved;
+};
+#pragma pack(pop)
+
+// A flat, open-addressing table of entries, keyed by an already well distributed hash
+class IFSFileTable
+{
+public:
+	// Constructors
+	IFSFileTable();
+	~IFSFileTable();
+
+	// Makes room for the given count of entries without growing
+	void Reserve(size_t Count);
+	// Removes all entries
+	void Clear();
+
+	// Adds an entry, replacing an existing one only if asked to, returns whether it was stored (Entries that don't fit the slot are refused)
+	bool Insert(uint64_t EntryHash, const IFSFileEntry& Entry, bool Overwrite);
+	// Finds an entry
+	bool Find(uint64_t EntryHash, IFSFileEntry& Result) const;
+
+	// Gets the count of entries
+	size_t GetCount() const;
+	// Gets the count of slots, always a power of two
+	size_t GetCapacity() const;
+	// Gets the slots, for storing the table as is
+	const IFSFileSlot* GetSlots() const;
+	// Gets the memory used by the table
+	size_t GetMemoryUsage() const;
+
+	// Replaces the table with a stored slot array
+	void LoadSlots(const IFSFileSlot* Slots, size_t Capacity, size_t Count);
+
+	// Finds an entry in a slot array, used on stored tables too
+	static const IFSFileSlot* FindSlot(const IFSFileSlot* Slots, size_t Capacity, uint64_t EntryHash);
+	// Converts a slot to an entry
+	static void ReadSlot(const IFSFileSlot& Slot, IFSFileEntry& Result);
+
+private:
+	// The slots
+	std::unique_ptr<IFSFileSlot[]> Slots;
+	// The count of slots
+	size_t Capacity;
+	// The count of entries
+	size_t Count;
+
+	// Resizes the table, keeping the entries
+	void Rehash(size_t NewCapacity);
+
+	// Prevent copies, the table can be large
+	IFSFileTable(const IFSFileTable&);
+	IFSFileTable& operator=(const IFSFileTable&);
+};
\ No newline at end of file
@@ -0,0 +1,443 @@
+#include "stdafx.h"
+
+// The class we are implementing
+#include "IFSIndexCache.h"
+
+// We need the following classes
+#include "BinaryWriter.h"
+#include "FileSystems.h"
+
+// We need the Win32 file api
+#include <Windows.h>
+
+// The index magic ('ifsx') and the current layout version
+#define IFS_INDEX_MAGIC 0x78736669
+#define IFS_INDEX_VERSION 2
+
+// -- Structures for the index, every section is 8 byte aligned so it can be used straight from the mapping
+
+#pragma pack(push, 1)
+struct IFSIndexHeader
+{
+	uint32_t Magic;
+	uint32_t Version;
+	uint32_t PackageCount;
+	uint32_t EntryCount;
+	uint64_t PackageEntryCount;
+	uint64_t SlotCount;
+
+	uint64_t PackagesOffset;
+	uint64_t EntriesOffset;
+	uint64_t PackageEntriesOffset;
+	uint64_t StringsOffset;
+	uint64_t StringsSize;
+
+	uint64_t IndexSize;
+};
+
+struct IFSIndexPackage
+{
+	uint64_t FileSize;
+	uint64_t LastWriteTime;
+	uint64_t HeaderHash;
+
+	uint64_t EntriesIndex;
+	uint32_t EntryCount;
+
+	uint32_t PathOffset;
+	uint32_t PathLength;
+	uint32_t Reserved;
+};
+
+struct IFSIndexEntry
+{
+	uint64_t EntryHash;
+
+	uint64_t FilePosition;
+	uint64_t FileSize;
+	uint64_t CompressedSize;
+	uint64_t Flags;
+
+	uint32_t FilePackageIndex;
+	uint32_t HiRes;
+};
+#pragma pack(pop)
+
+// -- Verify structures
+
+static_assert(sizeof(IFSIndexHeader) == 0x50, "Invalid IFSIndexHeader Size (Expected 0x50)");
+static_assert(sizeof(IFSIndexPackage) == 0x30, "Invalid IFSIndexPackage Size (Expected 0x30)");
+static_assert(sizeof(IFSIndexEntry) == 0x30, "Invalid IFSIndexEntry Size (Expected 0x30)");
+
+// -- End index structures
+
+// Builds an index entry from a file entry
+const IFSIndexEntry BuildIndexEntry(uint64_t EntryHash, const IFSFileEntry& Entry, bool HiRes)
+{
+	IFSIndexEntry Result;
+	// Assign
+	Result.EntryHash = EntryHash;
+	Result.FilePosition = Entry.FilePosition;
+	Result.FileSize = Entry.FileSize;
+	Result.CompressedSize = Entry.CompressedSize;
+	Result.Flags = Entry.Flags;
+	Result.FilePackageIndex = Entry.FilePackageIndex;
+	Result.HiRes = (HiRes) ? 1 : 0;
+
+	// Return it
+	return Result;
+}
+
+// Builds a file entry from an index entry
+const IFSFileEntry BuildFileEntry(const IFSIndexEntry& Entry)
+{
+	IFSFileEntry Result;
+	// Assign
+	Result.FilePackageIndex = Entry.FilePackageIndex;
+	Result.FilePosition = Entry.FilePosition;
+	Result.FileSize = Entry.FileSize;
+	Result.CompressedSize = Entry.CompressedSize;
+	Result.Flags = Entry.Flags;
+
+	// Return it
+	return Result;
+}
+
+IFSIndexCache::IFSIndexCache()
+{
+	// Defaults
+}
+
+IFSIndexCache::~IFSIndexCache()
+{
+	// Clean up
+	this->Close();
+}
+
+bool IFSIndexCache::Open(const std::string& IndexPath)
+{
+	// Clean up any previous index
+	this->Close();
+
+	// Map the index
+	if (!this->IndexFile.Open(IndexPath))
+		return false;
+
+	// Grab the whole index, zero-copy when mapped
+	if (this->IndexFile.GetSize() < sizeof(IFSIndexHeader) || !this->IndexFile.ReadSpan(0, this->IndexFile.GetSize(), this->IndexData))
+	{
+		// Failed
+		this->Close();
+		return false;
+	}
+
+	// Grab the header
+	auto Header = (const IFSIndexHeader*)this->IndexData.Data;
+	// Calculate the size of each section
+	auto PackagesSize = (uint64_t)Header->PackageCount * sizeof(IFSIndexPackage);
+	auto EntriesSize = Header->SlotCount * sizeof(IFSFileSlot);
+	auto PackageEntriesSize = Header->PackageEntryCount * sizeof(IFSIndexEntry);
+
+	// Verify the layout, an index from another version, or a partial write, is just ignored
+	if (Header->Magic != IFS_INDEX_MAGIC || Header->Version != IFS_INDEX_VERSION || Header->IndexSize != this->IndexData.Size
+		|| (Header->SlotCount & (Header->SlotCount - 1)) != 0 || Header->EntryCount > Header->SlotCount || Header->SlotCount > Header->IndexSize
+		|| Header->PackagesOffset > Header->IndexSize || PackagesSize > Header->IndexSize - Header->PackagesOffset
+		|| Header->EntriesOffset > Header->IndexSize || EntriesSize > Header->IndexSize - Header->EntriesOffset
+		|| Header->PackageEntriesOffset > Header->IndexSize || PackageEntriesSize > Header->IndexSize - Header->PackageEntriesOffset
+		|| Header->StringsOffset > Header->IndexSize || Header->StringsSize > Header->IndexSize - Header->StringsOffset)
+	{
+		// Failed
+		this->Close();
+		return false;
+	}
+
+	// Verify the package records point inside the index
+	for (uint32_t i = 0; i < Header->PackageCount; i++)
+	{
+		// Grab it
+		auto Package = this->GetPackage(i);
+		// Verify
+		if (Package->EntriesIndex > Header->PackageEntryCount || Package->EntryCount > Header->PackageEntryCount - Package->EntriesIndex || (uint64_t)Package->PathOffset + Package->PathLength > Header->StringsSize)
+		{
+			// Failed
+			this->Close();
+			return false;
+		}
+	}
+
+	// Verify the merged table only points at the stored packages, the loaded package lists are indexed by it
+	auto Slots = (const IFSFileSlot*)(this->IndexData.Data + Header->EntriesOffset);
+	// The count of used slots
+	uint64_t UsedSlots = 0;
+
+	// Iterate
+	for (uint64_t i = 0; i < Header->SlotCount; i++)
+	{
+		// Skip empty
+		if (Slots[i].PackageIndex == IFS_FILE_SLOT_EMPTY)
+			continue;
+
+		// Verify
+		if (Slots[i].PackageIndex >= Header->PackageCount)
+		{
+			// Failed
+			this->Close();
+			return false;
+		}
+
+		// Count it
+		UsedSlots++;
+	}
+
+	// The entry count must match too, it's reported as is
+	if (UsedSlots != Header->EntryCount)
+	{
+		// Failed
+		this->Close();
+		return false;
+	}
+
+	// Success
+	return true;
+}
+
+void IFSIndexCache::Close()
+{
+	// Release the data, then the mapping
+	this->IndexData.Data = nullptr;
+	this->IndexData.Size = 0;
+	this->IndexData.Storage.reset();
+
+	// Close the index
+	this->IndexFile.Close();
+}
+
+bool IFSIndexCache::MatchesPackages(const std::vector<std::string>& Paths, const std::vector<IFSPackageFingerprint>& Fingerprints) const
+{
+	// Make sure we're loaded
+	if (this->IndexData.Data == nullptr)
+		return false;
+
+	// Grab the header
+	auto Header = (const IFSIndexHeader*)this->IndexData.Data;
+	// Check the count
+	if (Header->PackageCount != Paths.size())
+		return false;
+
+	// Check each package, in order
+	for (uint32_t i = 0; i < Header->PackageCount; i++)
+	{
+		// Grab it
+		auto Package = this->GetPackage(i);
+		// Compare
+		if (Package->FileSize != Fingerprints[i].FileSize || Package->LastWriteTime != Fingerprints[i].LastWriteTime || Package->HeaderHash != Fingerprints[i].HeaderHash || this->GetPackagePath(Package) != Paths[i])
+			return false;
+	}
+
+	// They match
+	return true;
+}
+
+int32_t IFSIndexCache::FindPackage(const std::string& Path, const IFSPackageFingerprint& Fingerprint) const
+{
+	// Make sure we're loaded
+	if (this->IndexData.Data == nullptr)
+		return -1;
+
+	// Grab the header
+	auto Header = (const IFSIndexHeader*)this->IndexData.Data;
+
+	// Search the packages
+	for (uint32_t i = 0; i < Header->PackageCount; i++)
+	{
+		// Grab it
+		auto Package = this->GetPackage(i);
+		// Compare
+		if (Package->FileSize == Fingerprint.FileSize && Package->LastWriteTime == Fingerprint.LastWriteTime && Package->HeaderHash == Fingerprint.HeaderHash && this->GetPackagePath(Package) == Path)
+			return (int32_t)i;
+	}
+
+	// Not found, or changed
+	return -1;
+}
+
+void IFSIndexCache::LoadPackageEntries(uint32_t PackageIndex, std::vector<IFSPackageEntry>& Entries) const
+{
+	// Grab the header and package
+	auto Header = (const IFSIndexHeader*)this->IndexData.Data;
+	auto Package = this->GetPackage(PackageIndex);
+	// Grab the entries
+	auto PackageEntries = (const IFSIndexEntry*)(this->IndexData.Data + Header->PackageEntriesOffset) + Package->EntriesIndex;
+
+	// Prepare
+	Entries.reserve(Entries.size() + Package->EntryCount);
+
+	// Add them, in list file order
+	for (uint32_t i = 0; i < Package->EntryCount; i++)
+		Entries.emplace_back(PackageEntries[i].EntryHash, BuildFileEntry(PackageEntries[i]), PackageEntries[i].HiRes != 0);
+}
+
+bool IFSIndexCache::FindEntry(uint64_t EntryHash, IFSFileEntry& Result) const
+{
+	// Make sure we're loaded
+	if (this->IndexData.Data == nullptr)
+		return false;
+
+	// Grab the header and the merged table, it's stored as the table's slots
+	auto Header = (const IFSIndexHeader*)this->IndexData.Data;
+	auto Slots = (const IFSFileSlot*)(this->IndexData.Data + Header->EntriesOffset);
+
+	// Search it in place
+	auto Slot = IFSFileTable::FindSlot(Slots, (size_t)Header->SlotCount, EntryHash);
+	// Verify
+	if (Slot == nullptr)
+		return false;
+
+	// Found it
+	IFSFileTable::ReadSlot(*Slot, Result);
+	return true;
+}
+
+void IFSIndexCache::LoadEntries(IFSFileTable& Files) const
+{
+	// Make sure we're loaded
+	if (this->IndexData.Data == nullptr)
+		return;
+
+	// Grab the header and the merged table
+	auto Header = (const IFSIndexHeader*)this->IndexData.Data;
+	auto Slots = (const IFSFileSlot*)(this->IndexData.Data + Header->EntriesOffset);
+
+	// Copy the slots as is
+	Files.LoadSlots(Slots, (size_t)Header->SlotCount, Header->EntryCount);
+}
+
+size_t IFSIndexCache::GetEntryCount() const
+{
+	// Make sure we're loaded
+	if (this->IndexData.Data == nullptr)
+		return 0;
+
+	// Grab it from the header
+	return ((const IFSIndexHeader*)this->IndexData.Data)->EntryCount;
+}
+
+bool IFSIndexCache::WriteIndex(const std::string& IndexPath, const std::vector<std::string>& Paths, const std::vector<IFSPackageFingerprint>& Fingerprints, const std::vector<const std::vector<IFSPackageEntry>*>& PackageEntries, const IFSFileTable& Files)
+{
+	// Build the sections
+	std::vector<IFSIndexPackage> Packages;
+	std::vector<IFSIndexEntry> Resolved;
+	std::string Strings;
+
+	// Prepare
+	Packages.reserve(Paths.size());
+
+	// Build the package records and their resolved entries
+	for (size_t i = 0; i < Paths.size(); i++)
+	{
+		IFSIndexPackage Package;
+		// Clear it
+		std::memset(&Package, 0, sizeof(Package));
+
+		// Assign the fingerprint
+		Package.FileSize = Fingerprints[i].FileSize;
+		Package.LastWriteTime = Fingerprints[i].LastWriteTime;
+		Package.HeaderHash = Fingerprints[i].HeaderHash;
+		// Assign the path
+		Package.PathOffset = (uint32_t)Strings.size();
+		Package.PathLength = (uint32_t)Paths[i].size();
+		// Assign the entries
+		Package.EntriesIndex = Resolved.size();
+		Package.EntryCount = (uint32_t)PackageEntries[i]->size();
+
+		// Add the path
+		Strings.append(Paths[i]);
+
+		// Add the entries, in list file order
+		for (auto& Entry : *PackageEntries[i])
+			Resolved.emplace_back(BuildIndexEntry(Entry.EntryHash, Entry.Entry, Entry.HiRes));
+
+		// Add it
+		Packages.emplace_back(Package);
+	}
+
+	// Build the header
+	IFSIndexHeader Header;
+	// Clear it
+	std::memset(&Header, 0, sizeof(Header));
+
+	// Assign the layout
+	Header.Magic = IFS_INDEX_MAGIC;
+	Header.Version = IFS_INDEX_VERSION;
+	Header.PackageCount = (uint32_t)Packages.size();
+	Header.EntryCount = (uint32_t)Files.GetCount();
+	Header.PackageEntryCount = Resolved.size();
+	Header.SlotCount = Files.GetCapacity();
+	Header.PackagesOffset = sizeof(IFSIndexHeader);
+	Header.EntriesOffset = Header.PackagesOffset + (Packages.size() * sizeof(IFSIndexPackage));
+	Header.PackageEntriesOffset = Header.EntriesOffset + (Files.GetCapacity() * sizeof(IFSFileSlot));
+	Header.StringsOffset = Header.PackageEntriesOffset + (Resolved.size() * sizeof(IFSIndexEntry));
+	Header.StringsSize = Strings.size();
+	Header.IndexSize = Header.StringsOffset + Header.StringsSize;
+
+	// Write to a temporary file first, the index is only replaced once complete
+	auto TempPath = IndexPath + ".tmp";
+
+	// Whether or not the whole index was written
+	bool Written = false;
+
+	// Write it, the writer throws if the file is in use, or can't be written
+	try
+	{
+		auto Writer = BinaryWriter();
+		// Create it
+		if (Writer.Create(TempPath))
+		{
+			// Write the sections
+			Writer.Write((int8_t*)&Header, sizeof(IFSIndexHeader));
+			if (Packages.size() > 0)
+				Writer.Write((int8_t*)&Packages[0], (uint32_t)(Packages.size() * sizeof(IFSIndexPackage)));
+			if (Files.GetCapacity() > 0)
+				Writer.Write((int8_t*)Files.GetSlots(), (uint32_t)(Files.GetCapacity() * sizeof(IFSFileSlot)));
+			if (Resolved.size() > 0)
+				Writer.Write((int8_t*)&Resolved[0], (uint32_t)(Resolved.size() * sizeof(IFSIndexEntry)));
+			if (Strings.size() > 0)
+				Writer.Write((int8_t*)&Strings[0], (uint32_t)Strings.size());
+
+			// Make sure nothing was cut short
+			Written = (Writer.GetPosition() == Header.IndexSize);
+		}
+	}
+	catch (...)
+	{
+		// Failed, cleaned up below
+		Written = false;
+	}
+
+	// Swap it in, the previous index is kept on failure
+	if (!Written || MoveFileExA(TempPath.c_str(), IndexPath.c_str(), MOVEFILE_REPLACE_EXISTING) == FALSE)
+	{
+		// Remove what was written
+		FileSystems::DeleteFile(TempPath);
+		return false;
+	}
+
+	// Success
+	return true;
+}
+
+const IFSIndexPackage* IFSIndexCache::GetPackage(uint32_t PackageIndex) const
+{
+	// Grab the header
+	auto Header = (const IFSIndexHeader*)this->IndexData.Data;
+	// Grab the package
+	return (const IFSIndexPackage*)(this->IndexData.Data + Header->PackagesOffset) + PackageIndex;
+}
+
+std::string IFSIndexCache::GetPackagePath(const IFSIndexPackage* Package) const
+{
+	// Grab the header
+	auto Header = (const IFSIndexHeader*)this->IndexData.Data;
+	// Build the path
+	return std::string((const char*)(this->IndexData.Data + Header->StringsOffset + Package->PathOffset), Package->PathLength);
+}
\ No newline at end of file
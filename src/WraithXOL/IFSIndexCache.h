@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <string>
+
+// We need the IFS entry types
+#include "IFSLib.h"
+
+// A package record in the index file
+struct IFSIndexPackage;
+
+// Identifies the exact state of a package on disk
+struct IFSPackageFingerprint
+{
+	uint64_t FileSize;
+	uint64_t LastWriteTime;
+	uint64_t HeaderHash;
+
+	IFSPackageFingerprint() : FileSize(0), LastWriteTime(0), HeaderHash(0) { }
+};
+
+// A class that stores a mounted IFS directory on disk, so the next mount can skip parsing unchanged packages
+class IFSIndexCache
+{
+public:
+	// Constructors
+	IFSIndexCache();
+	~IFSIndexCache();
+
+	// Maps and validates an index file
+	bool Open(const std::string& IndexPath);
+	// Unmaps the index file
+	void Close();
+
+	// Whether or not the index describes exactly these packages, in this order
+	bool MatchesPackages(const std::vector<std::string>& Paths, const std::vector<IFSPackageFingerprint>& Fingerprints) const;
+	// Finds an unchanged package in the index, returns -1 if it's missing or changed
+	int32_t FindPackage(const std::string& Path, const IFSPackageFingerprint& Fingerprint) const;
+	// Loads the resolved list file entries of a package
+	void LoadPackageEntries(uint32_t PackageIndex, std::vector<IFSPackageEntry>& Entries) const;
+
+	// Finds an entry in the merged table, straight from the mapped index
+	bool FindEntry(uint64_t EntryHash, IFSFileEntry& Result) const;
+	// Copies the merged table into a loaded file table
+	void LoadEntries(IFSFileTable& Files) const;
+	// Gets the count of entries in the merged table
+	size_t GetEntryCount() const;
+
+	// Writes an index for the given packages, their resolved entries, and the merged table
+	static bool WriteIndex(const std::string& IndexPath, const std::vector<std::string>& Paths, const std::vector<IFSPackageFingerprint>& Fingerprints, const std::vector<const std::vector<IFSPackageEntry>*>& PackageEntries, const IFSFileTable& Files);
+
+private:
+	// The mapped index file
+	IFSMappedFile IndexFile;
+	// The mapped index data
+	IFSDataSpan IndexData;
+
+	// Gets a package record
+	const IFSIndexPackage* GetPackage(uint32_t PackageIndex) const;
+	// Gets the path of a package record
+	std::string GetPackagePath(const IFSIndexPackage* Package) const;
+};
\ No newline at end of file
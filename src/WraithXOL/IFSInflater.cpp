@@ -0,0 +1,212 @@
+#include "stdafx.h"
+
+// The class we are implementing
+#include "IFSInflater.h"
+
+// We always have zlib
+#include "zlib.h"
+
+// The optional backends
+#if defined(IFS_INFLATE_ZLIBNG)
+#include "zlib-ng.h"
+#endif
+#if defined(IFS_INFLATE_LIBDEFLATE)
+#include "libdeflate.h"
+#endif
+
+// An inflater using stock zlib, the stream is reset between entries
+class IFSZLibInflater : public IFSInflater
+{
+public:
+	IFSZLibInflater()
+	{
+		// Setup the stream
+		std::memset(&this->Stream, 0, sizeof(this->Stream));
+		this->Ready = (inflateInit(&this->Stream) == Z_OK);
+	}
+
+	virtual ~IFSZLibInflater()
+	{
+		// Clean up
+		if (this->Ready)
+			inflateEnd(&this->Stream);
+	}
+
+	virtual bool InflateBuffer(const uint8_t* Input, uint32_t InputSize, uint8_t* Output, uint32_t OutputSize)
+	{
+		// Reset it
+		if (!this->Ready || inflateReset(&this->Stream) != Z_OK)
+			return false;
+
+		// Setup the buffers
+		this->Stream.next_in = (Bytef*)Input;
+		this->Stream.avail_in = InputSize;
+		this->Stream.next_out = Output;
+		this->Stream.avail_out = OutputSize;
+
+		// Inflate it all
+		auto Result = inflate(&this->Stream, Z_FINISH);
+
+		// Make sure we got the whole entry
+		return ((Result == Z_STREAM_END || Result == Z_BUF_ERROR || Result == Z_OK) && this->Stream.total_out == OutputSize);
+	}
+
+private:
+	// The stream
+	z_stream Stream;
+	// Whether or not it was setup
+	bool Ready;
+};
+
+#if defined(IFS_INFLATE_ZLIBNG)
+// An inflater using zlib-ng's native api
+class IFSZLibNGInflater : public IFSInflater
+{
+public:
+	IFSZLibNGInflater()
+	{
+		// Setup the stream
+		std::memset(&this->Stream, 0, sizeof(this->Stream));
+		this->Ready = (zng_inflateInit(&this->Stream) == Z_OK);
+	}
+
+	virtual ~IFSZLibNGInflater()
+	{
+		// Clean up
+		if (this->Ready)
+			zng_inflateEnd(&this->Stream);
+	}
+
+	virtual bool InflateBuffer(const uint8_t* Input, uint32_t InputSize, uint8_t* Output, uint32_t OutputSize)
+	{
+		// Reset it
+		if (!this->Ready || zng_inflateReset(&this->Stream) != Z_OK)
+			return false;
+
+		// Setup the buffers
+		this->Stream.next_in = Input;
+		this->Stream.avail_in = InputSize;
+		this->Stream.next_out = Output;
+		this->Stream.avail_out = OutputSize;
+
+		// Inflate it all
+		auto Result = zng_inflate(&this->Stream, Z_FINISH);
+
+		// Make sure we got the whole entry
+		return ((Result == Z_STREAM_END || Result == Z_BUF_ERROR || Result == Z_OK) && this->Stream.total_out == OutputSize);
+	}
+
+private:
+	// The stream
+	zng_stream Stream;
+	// Whether or not it was setup
+	bool Ready;
+};
+#endif
+
+#if defined(IFS_INFLATE_LIBDEFLATE)
+// An inflater using libdeflate, which inflates whole buffers, as the unpacked size is known up front
+class IFSLibDeflateInflater : public IFSInflater
+{
+public:
+	IFSLibDeflateInflater()
+	{
+		// Allocate it
+		this->Decompressor = libdeflate_alloc_decompressor();
+	}
+
+	virtual ~IFSLibDeflateInflater()
+	{
+		// Clean up
+		if (this->Decompressor != nullptr)
+			libdeflate_free_decompressor(this->Decompressor);
+	}
+
+	virtual bool InflateBuffer(const uint8_t* Input, uint32_t InputSize, uint8_t* Output, uint32_t OutputSize)
+	{
+		// Make sure we have one
+		if (this->Decompressor == nullptr)
+			return false;
+
+		// The sizes used, anything past the end of the stream is ignored
+		size_t InputUsed = 0, OutputUsed = 0;
+		// Inflate it
+		auto Result = libdeflate_zlib_decompress_ex(this->Decompressor, Input, InputSize, Output, OutputSize, &InputUsed, &OutputUsed);
+
+		// Make sure we got the whole entry
+		return (Result == LIBDEFLATE_SUCCESS && OutputUsed == OutputSize);
+	}
+
+private:
+	// The decompressor
+	libdeflate_decompressor* Decompressor;
+};
+#endif
+
+std::unique_ptr<IFSInflater> IFSInflater::Create(IFSInflateBackend Backend)
+{
+	// Check the backend
+	switch (Backend)
+	{
+	case IFSInflateBackend::ZLib:
+		return std::make_unique<IFSZLibInflater>();
+#if defined(IFS_INFLATE_ZLIBNG)
+	case IFSInflateBackend::ZLibNG:
+		return std::make_unique<IFSZLibNGInflater>();
+#endif
+#if defined(IFS_INFLATE_LIBDEFLATE)
+	case IFSInflateBackend::LibDeflate:
+		return std::make_unique<IFSLibDeflateInflater>();
+#endif
+	default:
+		return nullptr;
+	}
+}
+
+bool IFSInflater::IsAvailable(IFSInflateBackend Backend)
+{
+	// Check the backend
+	switch (Backend)
+	{
+	case IFSInflateBackend::ZLib:
+		return true;
+#if defined(IFS_INFLATE_ZLIBNG)
+	case IFSInflateBackend::ZLibNG:
+		return true;
+#endif
+#if defined(IFS_INFLATE_LIBDEFLATE)
+	case IFSInflateBackend::LibDeflate:
+		return true;
+#endif
+	default:
+		return false;
+	}
+}
+
+const char* IFSInflater::GetName(IFSInflateBackend Backend)
+{
+	// Check the backend
+	switch (Backend)
+	{
+	case IFSInflateBackend::ZLib:
+		return "zlib";
+	case IFSInflateBackend::ZLibNG:
+		return "zlib-ng";
+	case IFSInflateBackend::LibDeflate:
+		return "libdeflate";
+	default:
+		return "unknown";
+	}
+}
+
+IFSInflateBackend IFSInflater::GetDefault()
+{
+	// Whole buffer inflates are the fastest, then zlib-ng
+#if defined(IFS_INFLATE_LIBDEFLATE)
+	return IFSInflateBackend::LibDeflate;
+#elif defined(IFS_INFLATE_ZLIBNG)
+	return IFSInflateBackend::ZLibNG;
+#else
+	return IFSInflateBackend::ZLib;
+#endif
+}
\ No newline at end of file
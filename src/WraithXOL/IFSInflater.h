@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+
+// The inflate backends, zlib is always built, define IFS_INFLATE_ZLIBNG or IFS_INFLATE_LIBDEFLATE to build the others (And link the library)
+enum class IFSInflateBackend
+{
+	// Stock zlib, entries are streamed through it as they are decrypted
+	ZLib,
+	// zlib-ng, through its native api
+	ZLibNG,
+	// libdeflate, whole entries at once
+	LibDeflate
+};
+
+// An inflater for whole entries, not safe to share between threads, each read context owns its own
+class IFSInflater
+{
+public:
+	virtual ~IFSInflater() { }
+
+	// Inflates a whole zlib stream, the output size must be exact, data past the end of the stream is ignored
+	virtual bool InflateBuffer(const uint8_t* Input, uint32_t InputSize, uint8_t* Output, uint32_t OutputSize) = 0;
+
+	// Creates an inflater, returns nothing if the backend wasn't built
+	static std::unique_ptr<IFSInflater> Create(IFSInflateBackend Backend);
+	// Whether or not a backend was built
+	static bool IsAvailable(IFSInflateBackend Backend);
+	// Gets the name of a backend
+	static const char* GetName(IFSInflateBackend Backend);
+	// Gets the fastest backend that was built
+	static IFSInflateBackend GetDefault();
+};
\ No newline at end of file
@@ -3,12 +3,45 @@
 // The class we are implementing
 #include "IFSLib.h"
 
+// We need the mount index and catalog
+#include "IFSIndexCache.h"
+#include "IFSCatalog.h"
+
 // We need the following classes
-#include "BinaryReader.h"
-#include "MemoryReader.h"
+#include "BitStreamReader.h"
+#include "IFSListFileReader.h"
+#include "IFSPathHash.h"
+#include "IFSEntrySink.h"
 #include "Compression.h"
 #include "FileSystems.h"
 #include "Hashing.h"
+#include "Console.h"
+
+// We need zlib to inflate entries as they are decrypted
+#include "zlib.h"
+
+// We need the following std classes
+#include <algorithm>
+#include <chrono>
+
+// Entries closer than this are merged into one sequential read
+#define IFS_READ_RUN_GAP 0x10000
+// The largest merged read
+#define IFS_READ_RUN_SIZE 0x1000000
+// The default count of entries prefetched ahead of a read
+#define IFS_READ_AHEAD_ENTRIES 32
+// The largest prefetch issued at once
+#define IFS_READ_AHEAD_SIZE 0x800000
+// The size of each encrypted block, every block has its own IV
+#define IFS_DECRYPT_BLOCK_SIZE 0x8000
+// The size decrypted at a time when only the start of an entry is read
+#define IFS_PEEK_DECRYPT_SIZE 0x200
+// Entries at least this large are decrypted across the workers by default
+#define IFS_PARALLEL_DECRYPT_SIZE 0x100000
+// The size decrypted across the workers at once, whole blocks
+#define IFS_PARALLEL_DECRYPT_SPAN 0x200000
+// The count of list file lines hashed together
+#define IFS_LIST_HASH_BATCH 64
 
 // Jenkens hash
 #include "JenkinsHash.h"
@@ -114,48 +147,96 @@ const uint32_t IntegralBufferSize(uint32_t Buffer)
 	return (Buffer / 4) + 1;
 }
 
-// Calculate the JenkensHashLittle2 of a value
-const uint64_t HashLookupString(std::string Value)
+// Calculate the JenkensHashLittle2 of a value, the scratch buffer is reused between calls
+const uint64_t HashLookupString(const char* Value, size_t Length, std::string& Scratch)
 {
 	// Constants
 	uint32_t Pb = 1;
 	uint32_t Pc = 2;
 
+	// Prepare the buffer
+	Scratch.resize(Length);
+
 	// Make it lowercase, replace '/' - '\\'
-	auto HashLower = Strings::Replace(Strings::ToLower(Value), "/", "\\");
+	for (size_t i = 0; i < Length; i++)
+		Scratch[i] = (Value[i] == '/') ? '\\' : (char)tolower((uint8_t)Value[i]);
+
 	// Hash it
-	hashlittle2(HashLower.c_str(), Value.size(), &Pc, &Pb);
+	hashlittle2(Scratch.c_str(), Length, &Pc, &Pb);
 
 	// Return actual hash
 	return Pc + ((uint64_t)Pb << 32);
 }
 
-// Reads a bit-len integer from the stream
-const int64_t ReadBitLenInteger(const uint8_t* Buffer, uint32_t BitIndex, uint32_t NumBits)
+// Checks the fused path hashes against HashLookupString and Hashing::HashXXHashString, and the batched lanes against the single line hashes
+const bool VerifyPathHash()
 {
-	int64_t Data = 0, Wei = 1;
+	// Sample paths, covering partial blocks, mixed case and separators, and both normalize paths
+	std::string Samples[] = { "", "a.iwi", "hires/Images/Weapons/AR_Standard_Col.iwi", "SOUND\\Music/Menu_Theme_01.mp3", std::string(0x280, 'Q') + "/Z.iwi" };
+	// Scratch buffer
+	std::string Scratch;
 
-	for (uint32_t j = 0; j < NumBits; j++)
+	// Check each sample
+	for (auto& Sample : Samples)
 	{
-		if ((((Buffer[BitIndex / 8]) >> (BitIndex % 8)) & 1) != 0) Data += Wei;
-		BitIndex++; Wei *= 2;
+		// Build the line
+		IFSListFileLine Line;
+		// Assign it
+		Line.Line = Sample.c_str();
+		Line.LineLength = Sample.size();
+		Line.Name = Sample.c_str();
+		Line.NameLength = Sample.size();
+		Line.HiRes = false;
+
+		// Hash it
+		uint64_t EntryHash = 0, LookupHash = 0;
+		IFSPathHash::HashLine(Line, EntryHash, LookupHash);
+
+		// Compare
+		if (EntryHash != Hashing::HashXXHashString(Sample) || LookupHash != HashLookupString(Sample.c_str(), Sample.size(), Scratch))
+			return false;
 	}
 
-	return Data;
-}
+	// Sample lines for the lanes, more than one batch with a partial one left over, mixed lengths, case and separators, and one too long for the lanes
+	std::string BatchSamples[] = { "Images/A.iwi", "images\\b.IWI", "SOUND/Music\\Menu_Theme_01.mp3", "hires/Images/Weapons/AR_Standard_Col.iwi", "x", "", "MiXeD\\CaSe/PaTh/File_0123456789ab.iwi", "a/b/c/d/e/f/g/h/i/j/k.dds", std::string(0x280, 'q') + "\\Z.IWI", "z/Y", "Sound\\Effects/Explosions/Grenade_Frag_Close_03.mp3" };
+	// The count of lines
+	const uint32_t BatchCount = (uint32_t)(sizeof(BatchSamples) / sizeof(BatchSamples[0]));
 
-// Reads a bit-len integer from the stream
-const uint64_t ReadBitLenUInteger(const uint8_t* Buffer, uint32_t BitIndex, uint32_t NumBits)
-{
-	uint64_t Data = 0, Wei = 1;
+	// Build the lines
+	IFSListFileLine Lines[BatchCount];
+	// Iterate
+	for (uint32_t i = 0; i < BatchCount; i++)
+	{
+		// The file name follows the last separator
+		auto NameStart = BatchSamples[i].find_last_of("\\/");
+		NameStart = (NameStart == std::string::npos) ? 0 : NameStart + 1;
+
+		// Assign it
+		Lines[i].Line = BatchSamples[i].c_str();
+		Lines[i].LineLength = BatchSamples[i].size();
+		Lines[i].Name = BatchSamples[i].c_str() + NameStart;
+		Lines[i].NameLength = BatchSamples[i].size() - NameStart;
+		Lines[i].HiRes = false;
+	}
+
+	// Hash them together, like the list file parser does
+	uint64_t EntryHashes[BatchCount], LookupHashes[BatchCount];
+	IFSPathHash::HashLines(Lines, BatchCount, EntryHashes, LookupHashes);
 
-	for (uint32_t j = 0; j < NumBits; j++)
+	// Each lane must match the single line hash
+	for (uint32_t i = 0; i < BatchCount; i++)
 	{
-		if ((((Buffer[BitIndex / 8]) >> (BitIndex % 8)) & 1) != 0) Data += Wei;
-		BitIndex++; Wei *= 2;
+		// Hash it
+		uint64_t EntryHash = 0, LookupHash = 0;
+		IFSPathHash::HashLine(Lines[i], EntryHash, LookupHash);
+
+		// Compare
+		if (EntryHashes[i] != EntryHash || LookupHashes[i] != LookupHash)
+			return false;
 	}
 
-	return Data;
+	// They match
+	return true;
 }
 
 // Structures for reading
@@ -255,6 +336,170 @@ union IVPartLength
 };
 #pragma pack(pop)
 
+// A name hash in the bet table, sorted to find entries by hash
+struct IFSBetHashEntry
+{
+	uint64_t NameHash;
+	uint32_t EntryIndex;
+};
+
+// Calculates the pieces covered by a package's MD5 table, the count is stored, but where the hashed data ends isn't
+bool GetIFSPieceLayout(const IFSHeader& Header, uint64_t FileSize, uint64_t& PieceCount, uint64_t& DataEnd)
+{
+	// Verify the table
+	if (Header.MD5PieceSize == 0 || Header.MD5TableSize == 0 || (Header.MD5TableSize % 16) != 0)
+		return false;
+	if (Header.MD5TablePos > FileSize || Header.MD5TableSize > (FileSize - Header.MD5TablePos))
+		return false;
+
+	// Calculate the count
+	PieceCount = Header.MD5TableSize / 16;
+
+	// The hashed data ends at one of the tables that follow it, take the first one that gives the stored piece count
+	uint64_t DataEnds[] = { Header.HetTablePos, Header.BetTablePos, Header.MD5TablePos, Header.ArchiveSize, FileSize };
+	// Sort them
+	std::sort(std::begin(DataEnds), std::end(DataEnds));
+
+	// Iterate
+	for (auto End : DataEnds)
+	{
+		// Check it
+		if (End > 0 && End <= FileSize && ((End + Header.MD5PieceSize - 1) / Header.MD5PieceSize) == PieceCount)
+		{
+			// Found it
+			DataEnd = End;
+			return true;
+		}
+	}
+
+	// Otherwise assume whole pieces, as far as the package goes
+	DataEnd = PieceCount * Header.MD5PieceSize;
+	// Clamp it
+	if (DataEnd > FileSize)
+		DataEnd = FileSize;
+
+	// Done
+	return true;
+}
+
+// Opens a package, verifying it, and fingerprints its state on disk
+std::unique_ptr<IFSMappedFile> OpenIFSPackage(const std::string& PackagePath, IFSPackageFingerprint& Fingerprint)
+{
+	// Prepare to map the package
+	auto Package = std::make_unique<IFSMappedFile>();
+	// Open it (Sharing mode!)
+	if (!Package->Open(PackagePath)) return nullptr;
+
+	// Read the header
+	IFSHeader Header;
+	// Verify magic
+	if (!Package->Read(0, Header) || Header.Magic != 0x7366696e) return nullptr;
+
+	// Constants
+	uint32_t Pb = 1;
+	uint32_t Pc = 2;
+
+	// Hash the header, it holds the table positions, so any repack changes it
+	hashlittle2(&Header, sizeof(IFSHeader), &Pc, &Pb);
+
+	// Assign the fingerprint
+	Fingerprint.FileSize = Package->GetSize();
+	Fingerprint.LastWriteTime = Package->GetLastWriteTime();
+	Fingerprint.HeaderHash = Pc + ((uint64_t)Pb << 32);
+
+	// Return it
+	return Package;
+}
+
+// Advances a big-endian CTR counter by a count of AES blocks
+void AdvanceIFSCounter(uint8_t* Counter, uint32_t Blocks)
+{
+	// Add from the last byte, carrying up
+	uint32_t Carry = Blocks;
+	// Iterate
+	for (int32_t i = 15; i >= 0 && Carry > 0; i--)
+	{
+		// Add it
+		Carry += Counter[i];
+		Counter[i] = (uint8_t)(Carry & 0xFF);
+		Carry >>= 8;
+	}
+}
+
+// Builds the IV of a block, from the entry's IV, every block has its own
+void BuildIFSBlockIV(const uint8_t* FileIV, uint32_t BlockStart, uint32_t BlockSize, uint8_t* BlockIV)
+{
+	// The counter, with where the block is, and how large
+	IVPartLength IVCounter = IVPartLength();
+	// Assign it
+	IVCounter.IVIndex = BlockStart;
+	IVCounter.IVBlockSize = BlockSize;
+
+	// Copy the entry part, then the counter
+	std::memcpy(BlockIV, FileIV, 8);
+	std::memcpy(BlockIV + 8, &IVCounter, 8);
+}
+
+// Calculates the start of an entry's IV from its file name
+uint32_t GetIFSNounce(const std::string& NameString)
+{
+	return Hashing::HashCRC32StringInt(NameString, (uint32_t)NameString.size());
+}
+
+// Loads the download bitmap of a package, returns nothing if it's complete, or doesn't have one
+std::unique_ptr<IFSDownloadBitmap> LoadIFSBitmap(const IFSMappedFile& Package)
+{
+	// Read the header
+	IFSHeader Header;
+	// Verify it
+	if (!Package.Read(0, Header) || Header.BitmapSize == 0 || Header.MD5PieceSize == 0)
+		return nullptr;
+
+	// The bitmap has a bit for each MD5 piece, use the table for the count if we can
+	uint64_t PieceCount = 0, DataEnd = 0;
+	// Otherwise, it's as far as the package goes
+	if (!GetIFSPieceLayout(Header, Package.GetSize(), PieceCount, DataEnd))
+		PieceCount = (Package.GetSize() + Header.MD5PieceSize - 1) / Header.MD5PieceSize;
+
+	// Read the bitmap
+	IFSDataSpan BitmapData;
+	// Verify it
+	if (!Package.ReadSpan(Header.BitmapPos, Header.BitmapSize, BitmapData))
+		return nullptr;
+
+	// Load it
+	auto Bitmap = std::make_unique<IFSDownloadBitmap>();
+	Bitmap->Load(BitmapData.Data, BitmapData.Size, Header.MD5PieceSize, PieceCount);
+
+	// Complete packages don't need checking
+	if (Bitmap->IsComplete())
+		return nullptr;
+
+	// Done
+	return Bitmap;
+}
+
+// Passes an already decoded entry to a sink, as if it was being decoded
+bool WriteDecodedEntry(const uint8_t* Data, uint32_t DataSize, IFSEntrySink& Sink)
+{
+	// Start it
+	if (!Sink.Begin(DataSize))
+		return false;
+
+	// Copy straight into the sink if we can
+	auto DirectBuffer = Sink.GetDirectBuffer();
+	// Check it
+	if (DirectBuffer != nullptr)
+	{
+		// Copy it
+		std::memcpy(DirectBuffer, Data, DataSize);
+		return true;
+	}
+
+	// Write it in one go
+	return Sink.Write(Data, DataSize);
+}
+
 IFSLib::IFSLib()
 {
 	// Initialize the library
@@ -263,12 +508,20 @@ IFSLib::IFSLib()
 
 IFSLib::~IFSLib()
 {
+	// Finish mounting first, the packages are still being merged
+	this->JoinMount();
+
 	// Clean up the library
+	this->IndexCache.reset();
 	this->IFSPackages.clear();
 	this->IFSPackages.shrink_to_fit();
+	this->PackageBitmaps.clear();
+
+	// Clean up the decoded entries
+	this->EntryCache.reset();
 
 	// Clean up encryption stuff
-	ctr_done(&this->EncryptionKey);
+	this->EntryCipher.reset();
 }
 
 void IFSLib::Initialize()
@@ -277,10 +530,8 @@ void IFSLib::Initialize()
 	if (!IFSEncryptionBuilt)
 		BuildIFSEncryptionTable();
 	
-	// We must setup the AES key with the default IV (AES192)
+	// We must setup the AES key (AES192), the IV is built per block
 	unsigned char AesKey[24] = { 0x15, 0x9a, 0x03, 0x25, 0xe0, 0x75, 0x2e, 0x80, 0xc6, 0xc0, 0x94, 0x2a, 0x50, 0x5c, 0x1c, 0x68, 0x8c, 0x17, 0xef, 0x53, 0x99, 0xf8, 0x68, 0x3c };
-	// Setup the default IV
-	unsigned int AesIV[4] = { 0x1010101, 0x1010101, 0x1010101, 0x1010101 };
 
 	// Initialize LibTomCrypt + LibTomMath
 	ltc_mp = ltm_desc;
@@ -288,8 +539,32 @@ void IFSLib::Initialize()
 	register_cipher(&aes_desc);
 	register_hash(&sha256_desc);
 
-	// Initialize
-	ctr_start(find_cipher("aes"), (unsigned char*)&AesIV[0], &AesKey[0], 24, 0, CTR_COUNTER_BIG_ENDIAN, &this->EncryptionKey);
+	// Initialize, this uses AES-NI when the cpu supports it
+	this->EntryCipher = std::make_unique<IFSCipher>(&AesKey[0], 24);
+
+	// Setup the workers used to load packages
+	this->WorkerPool = std::make_unique<IFSThreadPool>();
+
+	// Use the fused path hashes, as long as they match the reference ones
+	this->FusedPathHash = VerifyPathHash();
+
+	// Prefetch ahead of reads by default
+	this->ReadAheadEntries = IFS_READ_AHEAD_ENTRIES;
+
+	// Decrypt large entries across the workers by default
+	this->ParallelDecryptSize = IFS_PARALLEL_DECRYPT_SIZE;
+
+	// Use the fastest inflate backend that was built
+	this->InflateBackend = IFSInflater::GetDefault();
+
+	// Nothing loaded yet
+	this->LoadGeneration = 0;
+	this->MountPending = false;
+	this->UnparsedPackages = 0;
+	this->AbsentReads = 0;
+
+	// The decoded entry cache, off until a budget is set
+	this->EntryCache = std::make_unique<IFSEntryCache>();
 
 	// All set
 	IFSEncryptionBuilt = true;
@@ -297,53 +572,77 @@ void IFSLib::Initialize()
 
 void IFSLib::AddPackage(const std::string& PackagePath)
 {
+	// Finish mounting first, packages are merged in order
+	this->JoinMount();
+
+	// Open the package
+	IFSPackageFingerprint Fingerprint;
+	auto Package = OpenIFSPackage(PackagePath, Fingerprint);
+
+	// Make sure we opened
+	if (Package == nullptr)
+		return;
+
 	// Load the package, we don't want the list file
-	this->LoadPackageInternal(PackagePath, std::vector<std::string>());
+	auto Table = this->ParsePackageTable(std::move(Package), false, false);
+
+	// Merge it
+	if (Table != nullptr)
+	{
+		this->DetachIndexCache();
+		this->MergePackageTable(*Table);
+	}
 }
 
 std::vector<std::string> IFSLib::ParsePackage(const std::string& PackagePath)
 {
+	// Finish mounting first, packages are merged in order
+	this->JoinMount();
+
+	// Open the package
+	IFSPackageFingerprint Fingerprint;
+	auto Package = OpenIFSPackage(PackagePath, Fingerprint);
+
+	// Make sure we opened
+	if (Package == nullptr)
+		return std::vector<std::string>();
+
 	// Load the package, we want the list
-	auto Result = std::vector<std::string>();
+	auto Table = this->ParsePackageTable(std::move(Package), true, true);
 
-	// Read it
-	this->LoadPackageInternal(PackagePath, Result, true);
+	// Make sure we loaded
+	if (Table == nullptr)
+		return std::vector<std::string>();
+
+	// Merge it
+	this->DetachIndexCache();
+	this->MergePackageTable(*Table);
 
 	// Return it
-	return Result;
+	return std::move(Table->ListFile);
 }
 
-void IFSLib::LoadPackageInternal(const std::string& PackagePath, std::vector<std::string>& LoadedListFile, bool Audio)
+std::unique_ptr<IFSPackageTable> IFSLib::ParsePackageTable(std::unique_ptr<IFSMappedFile> Package, bool Audio, bool KeepListFile) const
 {
-	// Prepare to open the package
-	auto Reader = BinaryReader();
-	// Open it (Sharing mode!)
-	auto open = Reader.Open(PackagePath, true);
-
 	// Read the header
-	auto Header = Reader.Read<IFSHeader>();
+	IFSHeader Header;
 	// Verify magic
-	if (Header.Magic != 0x7366696e) return;
+	if (!Package->Read(0, Header) || Header.Magic != 0x7366696e) return nullptr;
 
-	// Prepare to load the het table first
-	Reader.SetPosition(Header.HetTablePos);
 	// Calculate table hashes
 	auto HetKey = HashString("(hash table)", 0x300);
 	auto BetKey = HashString("(block table)", 0x300);
 
 	// Calculate the list file hashs
 	uint64_t ListFileHash = 0;
+	bool HasListFile = false;
 
-	// A list of file entries
-	std::unordered_map<uint64_t, IFSFileEntry> FileEntries;
-
-	// Add the package to the cache
-	this->IFSPackages.emplace_back(PackagePath);
-	// Get index
-	auto PackageIndex = (uint32_t)(this->IFSPackages.size() - 1);
-
-	// Read result
-	uint64_t ReadResult = 0;
+	// Setup the private table, it's merged into the loaded files later
+	auto Table = std::make_unique<IFSPackageTable>();
+	// Assign the package
+	Table->Package = std::move(Package);
+	// Grab a reference to the mapped package
+	auto& PackageFile = *Table->Package;
 
 	IFSHetTable HetTable;
 	IFSBetTable BetTable;
@@ -353,22 +652,23 @@ void IFSLib::LoadPackageInternal(const std::string& PackagePath, std::vector<std
 	// Begin HetTable parse
 	{
 		// Read the het header
-		auto HetHeader = Reader.Read<IFSHetHeader>();
+		IFSHetHeader HetHeader;
+		// Verify
+		if (!PackageFile.Read(Header.HetTablePos, HetHeader)) return Table;
+
+		// We only need the table header, the block decrypts front to back so the rest can be skipped
+		auto HetSize = (HetHeader.DataSize < sizeof(IFSHetTable)) ? HetHeader.DataSize : (uint32_t)sizeof(IFSHetTable);
+
 		// Allocate a working buffer
-		auto HetBuffer = std::make_unique<uint32_t[]>(IntegralBufferSize(HetHeader.DataSize));
-		// Clear it
-		std::memset(HetBuffer.get(), 0, IntegralBufferSize(HetHeader.DataSize) * 4);
+		uint32_t HetBuffer[(sizeof(IFSHetTable) + 3) / 4] = { 0 };
 
-		// Read the data
-		Reader.Read((uint8_t*)HetBuffer.get(), HetHeader.DataSize, ReadResult);
+		// Read the data, we must copy it out as it's decrypted in-place
+		if (!PackageFile.ReadData(Header.HetTablePos + sizeof(IFSHetHeader), HetSize, (uint8_t*)&HetBuffer[0])) return Table;
 		// Decrypt the data
-		DecryptIFSBlock(HetBuffer.get(), IntegralBufferSize(HetHeader.DataSize), HetKey);
-
-		// Read the required hettable information
-		auto MemReader = MemoryReader((int8_t*)HetBuffer.get(), IntegralBufferSize(HetHeader.DataSize) * 4, true);
+		DecryptIFSBlock(&HetBuffer[0], IntegralBufferSize(HetSize), HetKey);
 
 		// Read het table
-		HetTable = MemReader.Read<IFSHetTable>();
+		std::memcpy(&HetTable, &HetBuffer[0], sizeof(IFSHetTable));
 
 		// Calculate masks
 		if (HetTable.HashEntrySize != 0x40)
@@ -377,68 +677,134 @@ void IFSLib::LoadPackageInternal(const std::string& PackagePath, std::vector<std
 		OrMask = (uint64_t)1 << (HetTable.HashEntrySize - 1);
 	}
 
-	// Jump to BetTable
-	Reader.SetPosition(Header.BetTablePos);
+	// The decrypted bet table, entries are decoded from it on demand
+	std::unique_ptr<uint32_t[]> BetBuffer;
+	// The packed entries
+	const uint8_t* TableEntries = nullptr;
+	uint64_t TableEntriesSize = 0;
+	// The size of each entry
+	uint32_t EntryBits = 0;
+	// The name hash of each entry, sorted so entries can be found by hash
+	std::vector<IFSBetHashEntry> SortedHashes;
 
 	// Begin BetTable parse
 	{
 		// Read the bet header
-		auto BetHeader = Reader.Read<IFSBetHeader>();
+		IFSBetHeader BetHeader;
+		// Verify
+		if (!PackageFile.Read(Header.BetTablePos, BetHeader)) return Table;
+
+		// The size of the working buffer
+		auto BetBufferSize = (uint64_t)IntegralBufferSize(BetHeader.DataSize) * 4;
+		// Verify it holds the table header, and fits the package, before allocating it
+		if (BetBufferSize < sizeof(IFSBetTable) || BetHeader.DataSize > PackageFile.GetSize()) return Table;
+
 		// Allocate a working buffer
-		auto BetBuffer = std::make_unique<uint32_t[]>(IntegralBufferSize(BetHeader.DataSize));
+		BetBuffer = std::make_unique<uint32_t[]>(IntegralBufferSize(BetHeader.DataSize));
 		// Clear it
-		std::memset(BetBuffer.get(), 0, IntegralBufferSize(BetHeader.DataSize) * 4);
+		std::memset(BetBuffer.get(), 0, (size_t)BetBufferSize);
 
-		// Read the data
-		Reader.Read((uint8_t*)BetBuffer.get(), BetHeader.DataSize, ReadResult);
+		// Read the data, we must copy it out as it's decrypted in-place
+		if (!PackageFile.ReadData(Header.BetTablePos + sizeof(IFSBetHeader), BetHeader.DataSize, (uint8_t*)BetBuffer.get())) return Table;
 		// Decrypt the data
 		DecryptIFSBlock(BetBuffer.get(), IntegralBufferSize(BetHeader.DataSize), BetKey);
 
-		// Read the required bettable information
-		auto MemReader = MemoryReader((int8_t*)BetBuffer.get(), IntegralBufferSize(BetHeader.DataSize) * 4, true);
-
 		// Read bet table
-		BetTable = MemReader.Read<IFSBetTable>();
+		std::memcpy(&BetTable, BetBuffer.get(), sizeof(IFSBetTable));
+
+		// Calculate the table sizes
+		TableEntriesSize = ((uint64_t)BetTable.TableEntrySize * BetTable.EntryCount + 7) / 8;
+		auto TableHashesSize = ((uint64_t)BetTable.HashSizeTotal * BetTable.EntryCount + 7) / 8;
+
+		// Verify the tables fit, they are used in place, every entry must take up some of them, so the count is bounded by the buffer
+		if (BetTable.EntryCount > 0 && (BetTable.TableEntrySize == 0 || BetTable.HashSizeTotal == 0)) return Table;
+		if (TableEntriesSize + TableHashesSize > BetBufferSize - sizeof(IFSBetTable)) return Table;
 
-		// Allocate memory for table entries, and hash table
-		auto TableEntries = std::make_unique<uint8_t[]>((BetTable.TableEntrySize * BetTable.EntryCount + 7) / 8);
-		auto TableHashes = std::make_unique<uint8_t[]>((BetTable.HashSizeTotal*BetTable.EntryCount + 7) / 8);
+		// Grab the tables, they follow the table header
+		TableEntries = (const uint8_t*)BetBuffer.get() + sizeof(IFSBetTable);
+		auto TableHashes = TableEntries + TableEntriesSize;
 
-		// Read the tables
-		MemReader.Read((BetTable.TableEntrySize * BetTable.EntryCount + 7) / 8, (int8_t*)TableEntries.get());
-		MemReader.Read((BetTable.HashSizeTotal * BetTable.EntryCount + 7) / 8, (int8_t*)TableHashes.get());
+		// The size of each entry
+		EntryBits = BetTable.BitCountFilePos + BetTable.BitCountFileSize + BetTable.BitCountCmpSize + BetTable.BitCountFlagSize + BetTable.BitCountHashSize + BetTable.HashArraySize;
 
-		// Offsets
-		uint32_t BitOffset = 0, HashOffset = 0;
+		// Allocate the hash column
+		auto NameHashes = std::make_unique<uint64_t[]>(BetTable.EntryCount);
 
-		// Prepare to parse and read each entry
+		// The hash of each entry
+		uint32_t HashFields[1] = { BetTable.HashSizeTotal };
+		uint64_t* HashColumns[1] = { NameHashes.get() };
+
+		// Decode the hashes, the only column we need for every entry
+		BitStreamReader(TableHashes, TableHashesSize).ReadRecords(0, BetTable.EntryCount, BetTable.HashSizeTotal, HashFields, 1, HashColumns);
+
+		// Build the sorted column
+		SortedHashes.resize(BetTable.EntryCount);
+		// Assign them
 		for (uint32_t i = 0; i < BetTable.EntryCount; i++)
 		{
-			// New entry, set index
-			IFSFileEntry Entry; Entry.FilePackageIndex = PackageIndex;
-
-			// Read data
-			Entry.FilePosition = ReadBitLenInteger(TableEntries.get(), BitOffset, BetTable.BitCountFilePos); BitOffset += BetTable.BitCountFilePos;
-			Entry.FileSize = ReadBitLenInteger(TableEntries.get(), BitOffset, BetTable.BitCountFileSize); BitOffset += BetTable.BitCountFileSize;
-			Entry.CompressedSize = ReadBitLenInteger(TableEntries.get(), BitOffset, BetTable.BitCountCmpSize); BitOffset += BetTable.BitCountCmpSize;
-			Entry.Flags = ReadBitLenInteger(TableEntries.get(), BitOffset, BetTable.BitCountFlagSize); BitOffset += BetTable.BitCountFlagSize;
+			SortedHashes[i].NameHash = NameHashes[i];
+			SortedHashes[i].EntryIndex = i;
+		}
 
-			// Skip over unknown data
-			BitOffset += BetTable.BitCountHashSize;
-			BitOffset += BetTable.HashArraySize;
+		// Sort them, duplicate hashes keep entry order so the last one can win
+		std::sort(SortedHashes.begin(), SortedHashes.end(), [](const IFSBetHashEntry& Lhs, const IFSBetHashEntry& Rhs)
+		{
+			return (Lhs.NameHash < Rhs.NameHash) || (Lhs.NameHash == Rhs.NameHash && Lhs.EntryIndex < Rhs.EntryIndex);
+		});
 
-			// Grab the hash and use as the key
-			auto NameHash = ReadBitLenUInteger(TableHashes.get(), HashOffset, BetTable.HashSizeTotal); HashOffset += BetTable.HashSizeTotal;
+		// Grab the entries
+		BitStreamReader EntryReader(TableEntries, TableEntriesSize);
+		// The position of the flags in an entry
+		auto FlagsBit = BetTable.BitCountFilePos + BetTable.BitCountFileSize + BetTable.BitCountCmpSize;
 
-			// Check for list file, starts at header size
-			if (Entry.FilePosition == Header.HeaderSize && Entry.Flags == 0x80000000)
-				ListFileHash = NameHash;
+		// Find the list file, it starts at header size, the last one wins
+		for (uint32_t i = BetTable.EntryCount; i-- != 0;)
+		{
+			// Decode just the position and flags
+			auto EntryBit = (uint64_t)i * EntryBits;
+			auto FilePosition = EntryReader.ReadBits(EntryBit, BetTable.BitCountFilePos);
+			auto Flags = EntryReader.ReadBits(EntryBit + FlagsBit, BetTable.BitCountFlagSize);
 
-			// Add it
-			FileEntries[NameHash] = Entry;
+			// Check for list file
+			if (FilePosition == Header.HeaderSize && Flags == 0x80000000)
+			{
+				ListFileHash = NameHashes[i];
+				HasListFile = true;
+				break;
+			}
 		}
 	}
 
+	// The reader for the packed entries
+	BitStreamReader EntryReader(TableEntries, TableEntriesSize);
+	// Decodes the entry with the given hash, the last entry wins when the hash repeats
+	auto ResolveEntry = [&SortedHashes, &EntryReader, &BetTable, EntryBits](uint64_t NameHash, IFSFileEntry& Result) -> bool
+	{
+		// Find it
+		auto Entry = std::upper_bound(SortedHashes.begin(), SortedHashes.end(), NameHash, [](uint64_t Lhs, const IFSBetHashEntry& Rhs) { return Lhs < Rhs.NameHash; });
+		// Verify
+		if (Entry == SortedHashes.begin() || (Entry - 1)->NameHash != NameHash)
+			return false;
+
+		// Grab the entry
+		auto EntryBit = (uint64_t)(Entry - 1)->EntryIndex * EntryBits;
+
+		// New entry, the index is set once merged
+		Result.FilePackageIndex = 0;
+
+		// Decode data
+		Result.FilePosition = EntryReader.ReadBits(EntryBit, BetTable.BitCountFilePos);
+		EntryBit += BetTable.BitCountFilePos;
+		Result.FileSize = EntryReader.ReadBits(EntryBit, BetTable.BitCountFileSize);
+		EntryBit += BetTable.BitCountFileSize;
+		Result.CompressedSize = EntryReader.ReadBits(EntryBit, BetTable.BitCountCmpSize);
+		EntryBit += BetTable.BitCountCmpSize;
+		Result.Flags = EntryReader.ReadBits(EntryBit, BetTable.BitCountFlagSize);
+
+		// Found it
+		return true;
+	};
+
 	// Calculates the hash
 	auto GetBetHash = [AndMask, OrMask](uint64_t Hash) -> uint64_t
 	{
@@ -450,163 +816,1556 @@ void IFSLib::LoadPackageInternal(const std::string& PackagePath, std::vector<std
 	};
 
 	// Find this packages '(listfile)', it provides the names of all file entries
-	if (FileEntries.find(ListFileHash) == FileEntries.end())
-		return;
-
-	auto& ListFile = FileEntries[ListFileHash];
+	IFSFileEntry ListFile;
+	// Resolve it
+	if (!HasListFile || !ResolveEntry(ListFileHash, ListFile))
+		return Table;
 
-	// Jump to the list file offset, and read the buffer, it's a string...
-	Reader.SetPosition(ListFile.FilePosition);
-	// Allocate a string
-	std::string ListFileBuffer;
-	// Resize
-	ListFileBuffer.resize(ListFile.FileSize);
+	// Grab the list file, it's a string, zero-copy when mapped
+	IFSDataSpan ListFileData;
+	// Read the buffer from the list file offset
+	if (ListFile.FileSize == 0 || !PackageFile.ReadSpan(ListFile.FilePosition, ListFile.FileSize, ListFileData))
+		return Table;
 
-	// Read into buffer
-	Reader.Read((uint8_t*)&ListFileBuffer[0], ListFile.FileSize, ReadResult);
+	// Grab the buffer
+	auto ListFileBuffer = (const char*)ListFileData.Data;
+	auto ListFileEnd = ListFileBuffer + ListFileData.Size;
 
 	// Find list
-	if (ListFileBuffer.find(".lst\r\n") == std::string::npos)
-		return;
-
-	// Split by delim
-	for (auto& Line : Strings::SplitString(ListFileBuffer, '\n', true))
+	const char ListMarker[] = ".lst\r\n";
+	if (std::search(ListFileBuffer, ListFileEnd, ListMarker, ListMarker + 6) == ListFileEnd)
+		return Table;
+
+	// Scratch buffers for hashing, they keep their capacity between lines
+	std::string NameBuffer;
+	std::string LookupBuffer;
+
+	// The lines waiting to be hashed, they are hashed in batches
+	IFSListFileLine Batch[IFS_LIST_HASH_BATCH];
+	uint64_t EntryHashes[IFS_LIST_HASH_BATCH];
+	uint64_t LookupHashes[IFS_LIST_HASH_BATCH];
+	uint32_t BatchCount = 0;
+
+	// Hashes and resolves the waiting lines, in list file order
+	auto ResolveBatch = [&]()
 	{
-		// Trim the line
-		Strings::Trim(Line);
+		// Hash them
+		if (this->FusedPathHash)
+		{
+			IFSPathHash::HashLines(Batch, BatchCount, EntryHashes, LookupHashes);
+		}
+		else
+		{
+			for (uint32_t i = 0; i < BatchCount; i++)
+			{
+				// Calculate XXHash
+				NameBuffer.assign(Batch[i].Name, Batch[i].NameLength);
+				EntryHashes[i] = Hashing::HashXXHashString(NameBuffer);
+				LookupHashes[i] = HashLookupString(Batch[i].Line, Batch[i].LineLength, LookupBuffer);
+			}
+		}
+
+		// Resolve them
+		for (uint32_t i = 0; i < BatchCount; i++)
+		{
+			// Add it, names are only built when asked for
+			if (KeepListFile)
+				Table->ListFile.emplace_back(Batch[i].Line, Batch[i].LineLength);
 
+			// Check for entry in file...
+			IFSFileEntry FileEntry;
+			// Add it, resolving hires happens on merge
+			if (ResolveEntry(GetBetHash(LookupHashes[i]), FileEntry))
+				Table->Entries.emplace_back(EntryHashes[i], FileEntry, Batch[i].HiRes);
+		}
+
+		// Reset
+		BatchCount = 0;
+	};
+
+	// Tokenize the list in place
+	IFSListFileReader Reader(ListFileBuffer, (size_t)ListFileData.Size);
+	IFSListFileLine Line;
+
+	// Iterate
+	while (Reader.ReadLine(Line))
+	{
 		// Only IWIs matter, unless we want audio
-		if (Strings::EndsWith(Line, ".iwi") || (Audio && Strings::EndsWith(Line, ".mp3")))
+		if (IFSListFileReader::EndsWith(Line, ".iwi", 4) || (Audio && IFSListFileReader::EndsWith(Line, ".mp3", 4)))
 		{
-			// Calculate XXHash
-			auto EntryHash = Hashing::HashXXHashString(FileSystems::GetFileName(Line));
-			auto BetHash = GetBetHash(HashLookupString(Line));
+			// Queue it
+			Batch[BatchCount++] = Line;
+			// Resolve once full
+			if (BatchCount == IFS_LIST_HASH_BATCH)
+				ResolveBatch();
+		}
+	}
 
-			// Add it
-			LoadedListFile.emplace_back(Line);
+	// Resolve the rest
+	if (BatchCount > 0)
+		ResolveBatch();
 
-			// Check for entry in file...
-			if (FileEntries.find(BetHash) != FileEntries.end())
-			{
-				// If exists, switch if hires!
-				if (this->IFSFiles.find(EntryHash) == this->IFSFiles.end())
-					this->IFSFiles[EntryHash] = FileEntries[BetHash];
-				else if (Strings::StartsWith(Line, "hires/"))
-					this->IFSFiles[EntryHash] = FileEntries[BetHash];
-			}
+	// Return it
+	return Table;
+}
+
+void IFSLib::MergePackageTable(IFSPackageTable& Table)
+{
+	// Add the package to the cache, with what's downloaded of it
+	this->PackageBitmaps.emplace_back(LoadIFSBitmap(*Table.Package));
+	this->IFSPackages.emplace_back(std::move(Table.Package));
+	// Get index
+	auto PackageIndex = (uint32_t)(this->IFSPackages.size() - 1);
+
+	// Make room for every entry up front (Entries of packages past the table's limit are not loaded)
+	this->IFSFiles.Reserve(this->IFSFiles.GetCount() + Table.Entries.size());
+
+	// Whether or not a loaded entry was replaced
+	bool Replaced = false;
+
+	// Apply the entries in list file order
+	for (auto& Entry : Table.Entries)
+	{
+		// Set index
+		Entry.Entry.FilePackageIndex = PackageIndex;
+
+		// Only hires entries replace loaded ones
+		if (Entry.HiRes && !Replaced)
+		{
+			IFSFileEntry Existing;
+			Replaced = this->IFSFiles.Find(Entry.EntryHash, Existing);
 		}
+
+		// If exists, switch if hires!
+		this->IFSFiles.Insert(Entry.EntryHash, Entry.Entry, Entry.HiRes);
+	}
+
+	// Replaced entries may be cached, or resolved into handles
+	if (Replaced)
+	{
+		this->EntryCache->Clear();
+		this->LoadGeneration++;
 	}
 }
 
-void IFSLib::MountIFSPath(const std::string& IFSPath)
+void IFSLib::MountIFSPath(const std::string& IFSPath, const std::string& IndexPath, bool Audio)
 {
+	// Finish mounting first, packages are merged in order
+	this->JoinMount();
+
 	// Load all ifs files from the given path
 	auto IFSFiles = FileSystems::GetFiles(IFSPath, "*.ifs");
 
-	// Iterate and load
-	for (auto& File : IFSFiles)
-		this->AddPackage(File);
+	// Mount them
+	this->MountPackages(IFSFiles, IndexPath, Audio);
 }
 
-size_t IFSLib::GetLoadedEntries()
+void IFSLib::MountIFSPathAsync(const std::string& IFSPath, const std::string& IndexPath)
 {
-	return this->IFSFiles.size();
+	// Finish mounting first, packages are merged in order
+	this->JoinMount();
+
+	// Load all ifs files from the given path
+	auto IFSFiles = FileSystems::GetFiles(IFSPath, "*.ifs");
+
+	// Make room for the packages up front, so the lists never move while lookups read them
+	this->IFSPackages.reserve(this->IFSPackages.size() + IFSFiles.size());
+	this->PackageBitmaps.reserve(this->PackageBitmaps.size() + IFSFiles.size());
+
+	// Lookups wait on the pending packages from here, until every one of them is parsed
+	this->UnparsedPackages = IFSFiles.size();
+	this->MountPending = true;
+
+	// Mount them in the background
+	this->MountThread = std::thread([this, IFSFiles, IndexPath]()
+	{
+		// Whether or not every package was mounted
+		bool Mounted = false;
+
+		// Nothing may escape the thread
+		try
+		{
+			this->MountPackages(IFSFiles, IndexPath, false);
+			Mounted = true;
+		}
+		catch (...)
+		{
+			// Log it, lookups are served from what was merged
+			Console::WriteLineHeader("IFS", "Failed to finish mounting the IFS directory");
+		}
+
+		// Wake the lookups still waiting, even if we failed part way
+		this->FinishMount();
+
+		// Log results, lookups are final from here
+		if (Mounted)
+			Console::WriteLineHeader("IFS", "Mounted IFS directory, loaded %d files", this->GetLoadedEntries());
+	});
 }
 
-std::unique_ptr<uint8_t[]> IFSLib::ReadFileEntry(const std::string& Name, uint32_t& ResultSize)
+void IFSLib::MountPackages(const std::vector<std::string>& IFSFiles, const std::string& IndexPath, bool Audio)
 {
-	// Multi-stage read, we must decrypt, then decompress the zlib buffer
-	auto NameString = FileSystems::GetFileName(Name);
-	auto NameHash = Hashing::HashXXHashString(NameString);
-	// Setup
-	ResultSize = 0;
+	// The index only describes a mount into an empty library, without audio
+	auto UseIndex = (!IndexPath.empty() && this->IFSPackages.size() == 0 && !Audio);
 
-	// Ensure existance first
-	if (this->IFSFiles.find(NameHash) == this->IFSFiles.end())
-		return nullptr;
+	// Prepare the packages
+	std::vector<std::unique_ptr<IFSMappedFile>> Packages(IFSFiles.size());
+	std::vector<IFSPackageFingerprint> Fingerprints(IFSFiles.size());
 
-	auto& FileEntry = this->IFSFiles[NameHash];
+	// Open and fingerprint each package in parallel
+	this->WorkerPool->ParallelFor(IFSFiles.size(), [&IFSFiles, &Packages, &Fingerprints](size_t Index)
+	{
+		Packages[Index] = OpenIFSPackage(IFSFiles[Index], Fingerprints[Index]);
+	});
 
-	// Open the package for reading
-	auto Reader = BinaryReader();
-	// Open it (Sharing mode!)
-	Reader.Open(this->IFSPackages[FileEntry.FilePackageIndex], true);
+	// The paths and fingerprints of the packages we'll mount, in order
+	std::vector<std::string> MountPaths;
+	std::vector<IFSPackageFingerprint> MountFingerprints;
 
-	// Hop to the offset
-	Reader.SetPosition(FileEntry.FilePosition);
+	// Build them
+	for (size_t i = 0; i < IFSFiles.size(); i++)
+	{
+		if (Packages[i] != nullptr)
+		{
+			MountPaths.emplace_back(IFSFiles[i]);
+			MountFingerprints.emplace_back(Fingerprints[i]);
+		}
+	}
 
-	uint64_t ReadResult = 0;
+	// Load the previous index
+	std::unique_ptr<IFSIndexCache> PreviousIndex = nullptr;
+	// Check if we want it
+	if (UseIndex)
+	{
+		// Map it
+		PreviousIndex = std::make_unique<IFSIndexCache>();
+		// Ignore it if it's missing or invalid
+		if (!PreviousIndex->Open(IndexPath))
+			PreviousIndex.reset();
+	}
 
-	// Read the data, it's encrypted right now though (Compressed size MUST = the full size here...)
-	auto MemReader = MemoryReader(Reader.Read(FileEntry.CompressedSize, ReadResult), ReadResult);
-	// The unpacked size is appended to the end
-	MemReader.SetPosition(MemReader.GetLength() - 4);
+	// If nothing changed, serve lookups straight from the index
+	if (PreviousIndex != nullptr && PreviousIndex->MatchesPackages(MountPaths, MountFingerprints))
+	{
+		// Adopt them while lookups are held off
+		{
+			std::lock_guard<std::mutex> Lock(this->MountMutex);
 
-	// Read this, it's used for the IV
-	auto UnpackedSize = MemReader.Read<uint32_t>();
-	auto PackedSize = (uint32_t)(MemReader.GetLength() - 4);
-	auto Nounce = Hashing::HashCRC32StringInt(NameString, (uint32_t)NameString.size());
+			// Adopt the packages, the index is in the same order
+			for (auto& Package : Packages)
+			{
+				if (Package != nullptr)
+				{
+					this->PackageBitmaps.emplace_back(LoadIFSBitmap(*Package));
+					this->IFSPackages.emplace_back(std::move(Package));
+				}
+			}
 
-	// Build the IV
-	auto FileIV = std::make_unique<uint8_t[]>(0x10);
+			// Use the index
+			this->IndexCache = std::move(PreviousIndex);
+		}
 
-	// Copy data
-	std::memset(FileIV.get(), 0, 0x10);
-	std::memcpy(FileIV.get(), &Nounce, 4);
-	std::memcpy(FileIV.get() + 4, &UnpackedSize, 4);
+		// Done
+		this->FinishMount();
+		return;
+	}
 
-	// Store the counter
-	IVPartLength IVCounter = IVPartLength();
+	// Prepare the private tables
+	std::vector<std::unique_ptr<IFSPackageTable>> Tables(IFSFiles.size());
+	// Which tables are done, and the next one to merge (Guarded by the mount mutex)
+	std::vector<uint8_t> TablesDone(IFSFiles.size(), 0);
+	size_t NextMerge = 0;
+	// Grab the index for the workers, it's read only
+	auto IndexData = PreviousIndex.get();
+
+	// Parse each package into its own table in parallel, unchanged packages are loaded from the index instead
+	this->WorkerPool->ParallelFor(IFSFiles.size(), [this, &IFSFiles, &Packages, &Fingerprints, &Tables, &TablesDone, &NextMerge, IndexData, Audio](size_t Index)
+	{
+		// Skip invalid packages
+		if (Packages[Index] != nullptr)
+		{
+			// Check the index
+			auto IndexPackage = (IndexData != nullptr) ? IndexData->FindPackage(IFSFiles[Index], Fingerprints[Index]) : -1;
+
+			// Parse it if it changed
+			if (IndexPackage < 0)
+			{
+				Tables[Index] = this->ParsePackageTable(std::move(Packages[Index]), Audio, false);
+			}
+			else
+			{
+				// Load it from the index
+				Tables[Index] = std::make_unique<IFSPackageTable>();
+				// Assign the package
+				Tables[Index]->Package = std::move(Packages[Index]);
+				// Load the entries
+				IndexData->LoadPackageEntries((uint32_t)IndexPackage, Tables[Index]->Entries);
+			}
+		}
 
-	// Go back to start
-	MemReader.SetPosition(0);
+		// Merge it as soon as the ones before it are, in path order, so hires overrides resolve exactly like loading one at a time
+		std::lock_guard<std::mutex> Lock(this->MountMutex);
+		// Mark it
+		TablesDone[Index] = 1;
 
-	// Allocate the result buffer
-	auto ResultBuffer = std::make_unique<uint8_t[]>(UnpackedSize);
+		// Lookups in the background must know what the pending packages may replace
+		if (this->MountPending)
+		{
+			// Count it
+			this->UnparsedPackages--;
 
-	// Read packed size
-	uint32_t ReadDataSize = 0;
-	uint32_t ReadUnpackedData = 0;
+			// Add its hires entries, until it's merged
+			if (Tables[Index] != nullptr)
+			{
+				for (auto& Entry : Tables[Index]->Entries)
+				{
+					if (Entry.HiRes)
+						this->PendingHiRes[Entry.EntryHash]++;
+				}
+			}
+		}
+
+		// Merge what's ready
+		while (NextMerge < Tables.size() && TablesDone[NextMerge] != 0)
+		{
+			if (Tables[NextMerge] != nullptr)
+			{
+				this->DetachIndexCache();
+				this->MergePackageTable(*Tables[NextMerge]);
+
+				// Its hires entries can't replace anything anymore
+				if (this->MountPending)
+				{
+					for (auto& Entry : Tables[NextMerge]->Entries)
+					{
+						if (!Entry.HiRes)
+							continue;
+
+						// Drop it once no pending package holds it
+						auto Pending = this->PendingHiRes.find(Entry.EntryHash);
+						// Check it
+						if (Pending != this->PendingHiRes.end() && --Pending->second == 0)
+							this->PendingHiRes.erase(Pending);
+					}
+				}
+			}
+
+			// Advance
+			NextMerge++;
+		}
+
+		// Wake the lookups waiting on it
+		this->MountSignal.notify_all();
+	});
 
-	// Working buffers
-	auto EncryptedBuffer = std::make_unique<uint8_t[]>(0x8000);
-	auto DecryptedBuffer = std::make_unique<uint8_t[]>(PackedSize);
+	// We're done with the previous index, it must be unmapped to be replaced
+	PreviousIndex.reset();
 
-	// We must decrypt
-	while (ReadDataSize < PackedSize)
+	// Every package is merged, lookups no longer wait
+	this->FinishMount();
+
+	// Write the new index
+	if (UseIndex)
 	{
-		// Ask for some data
-		auto Left = (PackedSize - ReadDataSize);
-		auto BlockSize = (Left > 0x8000) ? 0x8000 : Left;
+		// The resolved entries for each package
+		std::vector<const std::vector<IFSPackageEntry>*> PackageEntries;
+
+		// Build them
+		for (auto& Table : Tables)
+		{
+			if (Table != nullptr)
+				PackageEntries.emplace_back(&Table->Entries);
+		}
+
+		// Write it, failing here only costs us the next warm mount
+		IFSIndexCache::WriteIndex(IndexPath, MountPaths, MountFingerprints, PackageEntries, this->IFSFiles);
+	}
+}
+
+size_t IFSLib::GetLoadedEntries()
+{
+	// Packages may still be merged in the background
+	std::lock_guard<std::mutex> Lock(this->MountMutex);
 
-		// Shift the index
-		IVCounter.IVIndex = ReadDataSize;
-		IVCounter.IVBlockSize = BlockSize;
+	// Check the index
+	if (this->IndexCache != nullptr)
+		return this->IndexCache->GetEntryCount();
 
-		// Set the IV Counter
-		std::memcpy(FileIV.get() + 8, &IVCounter, 8);
-		// Set the current IV
-		ctr_setiv(&FileIV.get()[0], 0x10, &this->EncryptionKey);
+	return this->IFSFiles.GetCount();
+}
 
-		// Read the data, decrypt in-place, then unzip
-		MemReader.Read(BlockSize, (int8_t*)EncryptedBuffer.get());
+bool IFSLib::FindFileEntry(uint64_t EntryHash, IFSFileEntry& Result) const
+{
+	// Packages are still being mounted, wait on them if we must
+	if (this->MountPending)
+		return this->FindPendingFileEntry(EntryHash, Result);
 
-		// Decrypt the buffer
-		ctr_decrypt((uint8_t*)EncryptedBuffer.get(), (uint8_t*)DecryptedBuffer.get() + ReadDataSize, BlockSize, &this->EncryptionKey);
+	// Check the index
+	if (this->IndexCache != nullptr)
+		return this->IndexCache->FindEntry(EntryHash, Result);
 
-		// Advance
-		ReadDataSize += BlockSize;
+	// Check the loaded files
+	return this->IFSFiles.Find(EntryHash, Result);
+}
+
+bool IFSLib::FindPendingFileEntry(uint64_t EntryHash, IFSFileEntry& Result) const
+{
+	// Hold off the merges
+	std::unique_lock<std::mutex> Lock(this->MountMutex);
+
+	// Check each time a package is merged
+	while (true)
+	{
+		// Check what's loaded so far
+		auto Found = (this->IndexCache != nullptr) ? this->IndexCache->FindEntry(EntryHash, Result) : this->IFSFiles.Find(EntryHash, Result);
+
+		// Stop once nothing is left to merge
+		if (!this->MountPending)
+			return Found;
+		// The entry is final once every package is parsed, and none left to merge has a hires copy of it
+		if (Found && this->UnparsedPackages == 0 && this->PendingHiRes.count(EntryHash) == 0)
+			return true;
+
+		// Wait for the next package
+		this->MountSignal.wait(Lock);
 	}
+}
+
+bool IFSLib::IsMounting() const
+{
+	return this->MountPending;
+}
 
-	// Prepare to decompress
-	if (ReadDataSize > 0)
+void IFSLib::WaitForMount() const
+{
+	// Make sure we're mounting
+	if (!this->MountPending)
+		return;
+
+	// Wait for the last package
+	std::unique_lock<std::mutex> Lock(this->MountMutex);
+	// Wait
+	this->MountSignal.wait(Lock, [this] { return !this->MountPending; });
+}
+
+void IFSLib::FinishMount()
+{
+	// Nothing is pending
 	{
-		Compression::DecompressZLibBlock((int8_t*)DecryptedBuffer.get(), (int8_t*)ResultBuffer.get(), PackedSize, UnpackedSize);
+		std::lock_guard<std::mutex> Lock(this->MountMutex);
+		// Set it
+		this->MountPending = false;
+		// Every entry is final now
+		this->UnparsedPackages = 0;
+		this->PendingHiRes.clear();
 	}
 
-	// Set it up
-	ResultSize = UnpackedSize;
+	// Wake the lookups still waiting
+	this->MountSignal.notify_all();
+}
 
-	// Worked, return buffer
-	return ResultBuffer;
+void IFSLib::JoinMount()
+{
+	// Wait for the background mount, it may still be writing the index
+	if (this->MountThread.joinable())
+		this->MountThread.join();
+}
+
+void IFSLib::DetachIndexCache()
+{
+	// Make sure we have one
+	if (this->IndexCache == nullptr)
+		return;
+
+	// Load the entries
+	this->IndexCache->LoadEntries(this->IFSFiles);
+	// Close it
+	this->IndexCache.reset();
+}
+
+IFSEntryHandle IFSLib::Resolve(const std::string& Name) const
+{
+	// Resolve it from the file name
+	return this->ResolveFileName(FileSystems::GetFileName(Name));
+}
+
+IFSEntryHandle IFSLib::ResolveFileName(const std::string& NameString) const
+{
+	// Setup the handle
+	IFSEntryHandle Handle;
+	// Hash the name
+	Handle.EntryHash = Hashing::HashXXHashString(NameString);
+
+	// Find it
+	auto Found = this->FindFileEntry(Handle.EntryHash, Handle.Entry);
+	// Grab the generation after, a package merged in the background may have just replaced it
+	Handle.LoadGeneration = this->LoadGeneration;
+
+	// Verify it
+	if (!Found)
+		return Handle;
+
+	// The IV only depends on the name
+	Handle.Nounce = GetIFSNounce(NameString);
+	Handle.Found = true;
+	Handle.Present = this->IsEntryPresent(Handle.Entry);
+
+	// Done
+	return Handle;
+}
+
+bool IFSLib::IsCurrentHandle(const IFSEntryHandle& Handle) const
+{
+	// It must be found, against the packages loaded right now
+	if (!Handle.Found || Handle.LoadGeneration != this->LoadGeneration)
+		return false;
+
+	// Don't bother decoding what isn't there yet
+	if (!Handle.Present)
+	{
+		this->AbsentReads++;
+		return false;
+	}
+
+	// Ready
+	return true;
+}
+
+bool IFSLib::CanKeepEntry(const IFSEntryHandle& Handle) const
+{
+	// Check pending first, once it's clear nothing can replace the entry
+	if (this->MountPending)
+		return false;
+
+	// Make sure nothing replaced it since it was resolved
+	return (Handle.LoadGeneration == this->LoadGeneration);
+}
+
+bool IFSLib::IsEntryPresent(const IFSFileEntry& Entry) const
+{
+	// Grab the bitmap, complete packages don't have one
+	auto& Bitmap = this->PackageBitmaps[Entry.FilePackageIndex];
+
+	// Check it
+	return (Bitmap == nullptr || Bitmap->IsRangePresent(Entry.FilePosition, Entry.CompressedSize));
+}
+
+std::unique_ptr<uint8_t[]> IFSLib::ReadFileEntry(const std::string& Name, uint32_t& ResultSize) const
+{
+	// Resolve it, then read it
+	return this->ReadFileEntry(this->Resolve(Name), ResultSize);
+}
+
+bool IFSLib::ReadFileEntry(const std::string& Name, IFSEntrySink& Sink) const
+{
+	// Resolve it, then read it
+	return this->ReadFileEntry(this->Resolve(Name), Sink);
+}
+
+bool IFSLib::ReadFileEntry(const std::string& Name, IFSReadContext& Context) const
+{
+	// Grab the file name into the reused buffer, the same as FileSystems::GetFileName, without a new string
+	auto& NameString = Context.GetNameBuffer();
+	auto NameStart = Name.find_last_of("\\/");
+	// Assign it
+	if (NameStart == std::string::npos)
+		NameString.assign(Name);
+	else
+		NameString.assign(Name, NameStart + 1, std::string::npos);
+
+	// Resolve it, then read it
+	return this->ReadFileEntry(this->ResolveFileName(NameString), Context);
+}
+
+std::unique_ptr<uint8_t[]> IFSLib::PeekFileEntry(const std::string& Name, uint32_t MaxBytes, uint32_t& ResultSize) const
+{
+	// Resolve it, then read it
+	return this->PeekFileEntry(this->Resolve(Name), MaxBytes, ResultSize);
+}
+
+bool IFSLib::PeekFileEntry(const std::string& Name, uint32_t MaxBytes, IFSReadContext& Context) const
+{
+	// Grab the file name into the reused buffer
+	auto& NameString = Context.GetNameBuffer();
+	auto NameStart = Name.find_last_of("\\/");
+	// Assign it
+	if (NameStart == std::string::npos)
+		NameString.assign(Name);
+	else
+		NameString.assign(Name, NameStart + 1, std::string::npos);
+
+	// Resolve it, then read it
+	return this->PeekFileEntry(this->ResolveFileName(NameString), MaxBytes, Context);
+}
+
+std::unique_ptr<uint8_t[]> IFSLib::ReadFileEntry(const IFSEntryHandle& Handle, uint32_t& ResultSize) const
+{
+	// Setup
+	ResultSize = 0;
+
+	// Decode into a single buffer
+	IFSBufferSink Sink;
+	// Read it
+	if (!this->ReadFileEntry(Handle, Sink))
+		return nullptr;
+
+	// Worked, return buffer
+	return Sink.TakeBuffer(ResultSize);
+}
+
+bool IFSLib::ReadFileEntry(const IFSEntryHandle& Handle, IFSEntrySink& Sink) const
+{
+	// Ensure existance first
+	if (!this->IsCurrentHandle(Handle))
+		return false;
+
+	// Check if we decoded it recently
+	std::shared_ptr<const IFSCachedEntry> CachedEntry;
+	// Use it if so
+	if (this->EntryCache->Find(Handle.EntryHash, CachedEntry))
+		return WriteDecodedEntry(CachedEntry->Data.get(), CachedEntry->DataSize, Sink);
+
+	// Multi-stage read, we must decrypt, then decompress the zlib buffer, one block at a time
+	auto& FileEntry = Handle.Entry;
+
+	// Start reading it, and what follows, in the background
+	this->PrefetchFileEntry(FileEntry);
+
+	// Grab the entry data straight from the mapped package, it's encrypted right now though (Compressed size MUST = the full size here...)
+	IFSDataSpan EntryData;
+	// Verify it (The unpacked size is appended to the end)
+	if (FileEntry.CompressedSize < 4 || !this->IFSPackages[FileEntry.FilePackageIndex]->ReadSpan(FileEntry.FilePosition, FileEntry.CompressedSize, EntryData))
+		return false;
+
+	// Scratch buffers, only for this read
+	IFSReadContext Context;
+
+	// Large entries are streamed straight to the sink, as they won't be kept
+	if (!this->EntryCache->CanCache(FileEntry.FileSize) || !this->CanKeepEntry(Handle))
+		return this->DecodeFileEntry(Handle.Nounce, EntryData.Data, EntryData.Size, Sink, Context);
+
+	// Decode it into the context, so we can keep a copy
+	if (!this->DecodeFileEntry(Handle.Nounce, EntryData.Data, EntryData.Size, Context, Context))
+		return false;
+
+	// Keep it
+	this->EntryCache->Insert(Handle.EntryHash, Context.GetData(), Context.GetDataSize());
+
+	// Pass it on
+	return WriteDecodedEntry(Context.GetData(), Context.GetDataSize(), Sink);
+}
+
+bool IFSLib::ReadFileEntry(const IFSEntryHandle& Handle, IFSReadContext& Context) const
+{
+	// Ensure existance first
+	if (!this->IsCurrentHandle(Handle))
+		return false;
+
+	// Check if we decoded it recently
+	std::shared_ptr<const IFSCachedEntry> CachedEntry;
+	// Use it if so
+	if (this->EntryCache->Find(Handle.EntryHash, CachedEntry))
+		return WriteDecodedEntry(CachedEntry->Data.get(), CachedEntry->DataSize, Context);
+
+	// Grab the entry
+	auto& FileEntry = Handle.Entry;
+
+	// Start reading it, and what follows, in the background
+	this->PrefetchFileEntry(FileEntry);
+
+	// Grab the entry data straight from the mapped package (The unpacked size is appended to the end)
+	IFSDataSpan EntryData;
+	// Verify it
+	if (FileEntry.CompressedSize < 4 || !this->IFSPackages[FileEntry.FilePackageIndex]->ReadSpan(FileEntry.FilePosition, FileEntry.CompressedSize, EntryData))
+		return false;
+
+	// Decode it into the context's own buffer
+	if (!this->DecodeFileEntry(Handle.Nounce, EntryData.Data, EntryData.Size, Context, Context))
+		return false;
+
+	// Keep it, if it's worth it
+	if (this->CanKeepEntry(Handle))
+		this->EntryCache->Insert(Handle.EntryHash, Context.GetData(), Context.GetDataSize());
+
+	// Success
+	return true;
+}
+
+std::unique_ptr<uint8_t[]> IFSLib::PeekFileEntry(const IFSEntryHandle& Handle, uint32_t MaxBytes, uint32_t& ResultSize) const
+{
+	// Setup
+	ResultSize = 0;
+
+	// Scratch buffers, only for this read
+	IFSReadContext Context;
+
+	// Read it
+	if (!this->PeekFileEntry(Handle, MaxBytes, Context))
+		return nullptr;
+
+	// Copy out the result
+	ResultSize = Context.GetDataSize();
+	auto Result = std::make_unique<uint8_t[]>(ResultSize);
+	// Copy it
+	std::memcpy(Result.get(), Context.GetData(), ResultSize);
+
+	// Done
+	return Result;
+}
+
+bool IFSLib::PeekFileEntry(const IFSEntryHandle& Handle, uint32_t MaxBytes, IFSReadContext& Context) const
+{
+	// Ensure existance first
+	if (!this->IsCurrentHandle(Handle))
+		return false;
+
+	// Grab the entry
+	auto& FileEntry = Handle.Entry;
+
+	// Grab the entry data straight from the mapped package, only the pages we decrypt are touched (The unpacked size is appended to the end)
+	IFSDataSpan EntryData;
+	// Verify it
+	if (FileEntry.CompressedSize < 4 || !this->IFSPackages[FileEntry.FilePackageIndex]->ReadSpan(FileEntry.FilePosition, FileEntry.CompressedSize, EntryData))
+		return false;
+
+	// Decode just the start
+	return this->DecodeFileEntry(Handle.Nounce, EntryData.Data, EntryData.Size, Context, Context, MaxBytes);
+}
+
+size_t IFSLib::ReadFileEntries(const std::vector<std::string>& Names, const std::function<void(size_t Index, std::unique_ptr<uint8_t[]>& Data, uint32_t DataSize)>& Callback) const
+{
+	// Scratch buffers, shared by the whole batch
+	IFSReadContext Context;
+
+	// The entries we must read, and where they came from, all of them unless the cache is on
+	std::vector<std::string> ReadNames;
+	std::vector<size_t> ReadIndices;
+	std::vector<uint64_t> ReadHashes;
+
+	// Whether or not the cache is on, it's skipped while packages may still replace entries
+	auto UseCache = (this->EntryCache->GetBudget() > 0 && !this->MountPending);
+
+	// Deliver what we have cached first
+	if (UseCache)
+	{
+		// Iterate
+		for (size_t i = 0; i < Names.size(); i++)
+		{
+			// Hash it
+			auto NameHash = Hashing::HashXXHashString(FileSystems::GetFileName(Names[i]));
+
+			// Check if we decoded it recently
+			std::shared_ptr<const IFSCachedEntry> CachedEntry;
+			// Check it
+			if (this->EntryCache->Find(NameHash, CachedEntry))
+			{
+				// Copy it, the callback owns the result
+				auto Result = std::make_unique<uint8_t[]>(CachedEntry->DataSize);
+				std::memcpy(Result.get(), CachedEntry->Data.get(), CachedEntry->DataSize);
+
+				// Deliver it
+				Callback(i, Result, CachedEntry->DataSize);
+			}
+			else
+			{
+				// Read it
+				ReadNames.emplace_back(Names[i]);
+				ReadIndices.emplace_back(i);
+				ReadHashes.emplace_back(NameHash);
+			}
+		}
+	}
+
+	// Read them, decoding each one as it's read
+	auto AbsentCount = this->ReadPackedEntries(UseCache ? ReadNames : Names, [this, &Names, &Callback, &Context, UseCache, &ReadIndices, &ReadHashes](size_t Index, const uint8_t* EntryData, uint64_t EntrySize, bool Mapped)
+	{
+		// Grab the original index
+		auto NameIndex = (UseCache) ? ReadIndices[Index] : Index;
+
+		// Decode into a single buffer
+		IFSBufferSink Sink;
+		// Decode it
+		if (!this->DecodeFileEntry(GetIFSNounce(FileSystems::GetFileName(Names[NameIndex])), EntryData, EntrySize, Sink, Context))
+			return;
+
+		// Take the result
+		uint32_t ResultSize = 0;
+		auto Result = Sink.TakeBuffer(ResultSize);
+
+		// Keep it, if it's worth it
+		if (UseCache)
+			this->EntryCache->Insert(ReadHashes[Index], Result.get(), ResultSize);
+
+		// Deliver it
+		Callback(NameIndex, Result, ResultSize);
+	});
+
+	// Count the ones that aren't downloaded yet, like single reads
+	this->AbsentReads += AbsentCount;
+
+	// Done
+	return AbsentCount;
+}
+
+size_t IFSLib::ReadPackedEntries(const std::vector<std::string>& Names, const std::function<void(size_t Index, const uint8_t* Data, uint64_t DataSize, bool Mapped)>& Callback) const
+{
+	// A resolved request
+	struct IFSEntryRequest
+	{
+		size_t Index;
+		IFSFileEntry Entry;
+	};
+
+	// Resolve every name up front
+	std::vector<IFSEntryRequest> Requests;
+	// Prepare
+	Requests.reserve(Names.size());
+
+	// The count of entries that aren't downloaded yet
+	size_t AbsentCount = 0;
+
+	// Iterate
+	for (size_t i = 0; i < Names.size(); i++)
+	{
+		IFSEntryRequest Request;
+		// Assign
+		Request.Index = i;
+
+		// Find it, missing entries are skipped (The unpacked size is appended to the end)
+		if (!this->FindFileEntry(Hashing::HashXXHashString(FileSystems::GetFileName(Names[i])), Request.Entry) || Request.Entry.CompressedSize < 4)
+			continue;
+
+		// Skip it if it isn't downloaded yet
+		if (!this->IsEntryPresent(Request.Entry))
+		{
+			AbsentCount++;
+			continue;
+		}
+
+		// Read it
+		Requests.emplace_back(Request);
+	}
+
+	// Group them by package, in the order they are stored
+	std::sort(Requests.begin(), Requests.end(), [](const IFSEntryRequest& Lhs, const IFSEntryRequest& Rhs)
+	{
+		if (Lhs.Entry.FilePackageIndex != Rhs.Entry.FilePackageIndex)
+			return Lhs.Entry.FilePackageIndex < Rhs.Entry.FilePackageIndex;
+
+		return Lhs.Entry.FilePosition < Rhs.Entry.FilePosition;
+	});
+
+	// Delivers an entry's packed data, it points into the package when it's mapped
+	auto DeliverEntry = [this, &Callback](const IFSEntryRequest& Request, const uint8_t* EntryData)
+	{
+		Callback(Request.Index, EntryData, Request.Entry.CompressedSize, this->IFSPackages[Request.Entry.FilePackageIndex]->IsMapped());
+	};
+
+	// Read them in runs, merging entries that are close together into one sequential read
+	size_t RunStart = 0;
+	// The next entry to prefetch
+	size_t PrefetchNext = 0;
+
+	// Iterate
+	while (RunStart < Requests.size())
+	{
+		// Grab the package
+		auto PackageIndex = Requests[RunStart].Entry.FilePackageIndex;
+		auto& Package = *this->IFSPackages[PackageIndex];
+
+		// The range of the run
+		auto RunBegin = Requests[RunStart].Entry.FilePosition;
+		auto RunEnd = RunBegin + Requests[RunStart].Entry.CompressedSize;
+		auto RunFinish = RunStart + 1;
+
+		// Extend it while the next entry is nearby, and the run isn't too large
+		while (RunFinish < Requests.size())
+		{
+			// Grab the entry
+			auto& Entry = Requests[RunFinish].Entry;
+			// Calculate the new end
+			auto EntryEnd = Entry.FilePosition + Entry.CompressedSize;
+			auto NewEnd = (EntryEnd > RunEnd) ? EntryEnd : RunEnd;
+
+			// Check it
+			if (Entry.FilePackageIndex != PackageIndex || Entry.FilePosition > (RunEnd + IFS_READ_RUN_GAP) || (NewEnd - RunBegin) > IFS_READ_RUN_SIZE)
+				break;
+
+			// Extend it
+			RunEnd = NewEnd;
+			RunFinish++;
+		}
+
+		// Prefetch this run, and the entries after it, so the disk is busy while we decode
+		if (this->ReadAheadEntries > 0)
+		{
+			// The end of the read ahead
+			auto PrefetchEnd = RunFinish + (size_t)this->ReadAheadEntries;
+			// Limit it
+			if (PrefetchEnd > Requests.size())
+				PrefetchEnd = Requests.size();
+			// Skip what we already asked for
+			if (PrefetchNext < RunStart)
+				PrefetchNext = RunStart;
+
+			// Iterate
+			while (PrefetchNext < PrefetchEnd)
+			{
+				// The range to prefetch
+				auto& FirstEntry = Requests[PrefetchNext].Entry;
+				auto RangeBegin = FirstEntry.FilePosition;
+				auto RangeEnd = RangeBegin + FirstEntry.CompressedSize;
+				auto RangeFinish = PrefetchNext + 1;
+
+				// Merge nearby entries into one request
+				while (RangeFinish < PrefetchEnd)
+				{
+					// Grab the entry
+					auto& Entry = Requests[RangeFinish].Entry;
+					// Calculate the new end
+					auto EntryEnd = Entry.FilePosition + Entry.CompressedSize;
+					auto NewEnd = (EntryEnd > RangeEnd) ? EntryEnd : RangeEnd;
+
+					// Check it
+					if (Entry.FilePackageIndex != FirstEntry.FilePackageIndex || Entry.FilePosition > (RangeEnd + IFS_READ_RUN_GAP) || (NewEnd - RangeBegin) > IFS_READ_AHEAD_SIZE)
+						break;
+
+					// Extend it
+					RangeEnd = NewEnd;
+					RangeFinish++;
+				}
+
+				// Ask for it
+				this->IFSPackages[FirstEntry.FilePackageIndex]->Prefetch(RangeBegin, RangeEnd - RangeBegin);
+
+				// Next range
+				PrefetchNext = RangeFinish;
+			}
+		}
+
+		// Read the run in one go, zero-copy when the package is mapped
+		IFSDataSpan RunData;
+		// Check it
+		if (Package.ReadSpan(RunBegin, RunEnd - RunBegin, RunData))
+		{
+			// Decode each entry from the run
+			for (auto i = RunStart; i < RunFinish; i++)
+				DeliverEntry(Requests[i], RunData.Data + (Requests[i].Entry.FilePosition - RunBegin));
+		}
+		else
+		{
+			// Part of the run is invalid, read them one at a time
+			for (auto i = RunStart; i < RunFinish; i++)
+			{
+				// Read the entry
+				IFSDataSpan EntryData;
+				// Check it
+				if (Package.ReadSpan(Requests[i].Entry.FilePosition, Requests[i].Entry.CompressedSize, EntryData))
+					DeliverEntry(Requests[i], EntryData.Data);
+			}
+		}
+
+		// Next run
+		RunStart = RunFinish;
+	}
+
+	// Report what we skipped
+	return AbsentCount;
+}
+
+bool IFSLib::DecodePackedEntry(const std::string& Name, const uint8_t* Data, uint64_t DataSize, IFSEntrySink& Sink, IFSReadContext& Context) const
+{
+	// Verify it (The unpacked size is appended to the end)
+	if (Data == nullptr || DataSize < 4)
+		return false;
+
+	// Decode it, the nonce is from the file name
+	return this->DecodeFileEntry(GetIFSNounce(FileSystems::GetFileName(Name)), Data, DataSize, Sink, Context);
+}
+
+bool IFSLib::VerifyPackage(const std::string& PackagePath, IFSVerifyResult& Result) const
+{
+	// Reset the result
+	Result = IFSVerifyResult();
+
+	// Open the package
+	IFSMappedFile Package;
+	// Verify
+	if (!Package.Open(PackagePath))
+		return false;
+
+	// Start timing
+	auto StartTime = std::chrono::steady_clock::now();
+
+	// Check every piece
+	auto Success = this->VerifyPackagePieces(Package, nullptr, Result);
+
+	// Finish timing
+	Result.Seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - StartTime).count();
+
+	// Done
+	return Success;
+}
+
+bool IFSLib::VerifyFileEntries(const std::vector<std::string>& Names, IFSVerifyResult& Result) const
+{
+	// This covers every loaded package, wait for the ones still being mounted
+	this->WaitForMount();
+
+	// Reset the result
+	Result = IFSVerifyResult();
+
+	// Start timing
+	auto StartTime = std::chrono::steady_clock::now();
+
+	// The entries we found, and the pieces backing them, by package
+	std::vector<std::pair<size_t, IFSFileEntry>> Entries;
+	std::vector<std::vector<uint64_t>> PackagePieces(this->IFSPackages.size());
+
+	// Whether or not every package could be checked
+	auto Success = true;
+
+	// Iterate
+	for (size_t i = 0; i < Names.size(); i++)
+	{
+		// Find it, missing entries have nothing to check
+		IFSFileEntry FileEntry;
+		// Check it
+		if (!this->FindFileEntry(Hashing::HashXXHashString(FileSystems::GetFileName(Names[i])), FileEntry) || FileEntry.CompressedSize == 0)
+			continue;
+
+		// Read the header, for the piece size
+		IFSHeader Header;
+		// Verify it
+		if (!this->IFSPackages[FileEntry.FilePackageIndex]->Read(0, Header) || Header.MD5PieceSize == 0)
+		{
+			// It can't be checked
+			Success = false;
+			continue;
+		}
+
+		// Add the pieces the entry spans
+		auto FirstPiece = FileEntry.FilePosition / Header.MD5PieceSize;
+		auto LastPiece = (FileEntry.FilePosition + FileEntry.CompressedSize - 1) / Header.MD5PieceSize;
+		// Iterate
+		for (auto Piece = FirstPiece; Piece <= LastPiece; Piece++)
+			PackagePieces[FileEntry.FilePackageIndex].emplace_back(Piece);
+
+		// Keep it
+		Entries.emplace_back(i, FileEntry);
+	}
+
+	// The first failed range of each package
+	std::vector<size_t> PackageRanges(this->IFSPackages.size() + 1, 0);
+
+	// Check each package
+	for (size_t i = 0; i < this->IFSPackages.size(); i++)
+	{
+		// Mark the ranges
+		PackageRanges[i] = Result.BadRanges.size();
+
+		// Grab the pieces
+		auto& Pieces = PackagePieces[i];
+		// Skip if none
+		if (Pieces.empty())
+			continue;
+
+		// Sort them, dropping pieces shared by neighbouring entries
+		std::sort(Pieces.begin(), Pieces.end());
+		Pieces.erase(std::unique(Pieces.begin(), Pieces.end()), Pieces.end());
+
+		// Check them
+		if (!this->VerifyPackagePieces(*this->IFSPackages[i], &Pieces, Result))
+			Success = false;
+	}
+
+	// Mark the end
+	PackageRanges[this->IFSPackages.size()] = Result.BadRanges.size();
+
+	// Find the entries that overlap a failed range
+	for (auto& Entry : Entries)
+	{
+		// Grab the entry
+		auto& FileEntry = Entry.second;
+		auto EntryEnd = FileEntry.FilePosition + FileEntry.CompressedSize;
+
+		// Check each failed range of the package
+		for (auto r = PackageRanges[FileEntry.FilePackageIndex]; r < PackageRanges[FileEntry.FilePackageIndex + 1]; r++)
+		{
+			// Grab the range
+			auto& Range = Result.BadRanges[r];
+
+			// Check it
+			if (FileEntry.FilePosition < (Range.Offset + Range.Size) && Range.Offset < EntryEnd)
+			{
+				// It's bad
+				Result.BadEntries.emplace_back(Entry.first);
+				break;
+			}
+		}
+	}
+
+	// Keep them in request order
+	std::sort(Result.BadEntries.begin(), Result.BadEntries.end());
+
+	// Finish timing
+	Result.Seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - StartTime).count();
+
+	// Done
+	return Success;
+}
+
+bool IFSLib::VerifyPackagePieces(const IFSMappedFile& Package, const std::vector<uint64_t>* Pieces, IFSVerifyResult& Result) const
+{
+	// Read the header
+	IFSHeader Header;
+	// Verify magic
+	if (!Package.Read(0, Header) || Header.Magic != 0x7366696e)
+		return false;
+
+	// Work out the pieces
+	uint64_t PieceCount = 0, DataEnd = 0;
+	// Verify
+	if (!GetIFSPieceLayout(Header, Package.GetSize(), PieceCount, DataEnd))
+		return false;
+
+	// Read the table
+	IFSDataSpan HashTable;
+	// Verify
+	if (!Package.ReadSpan(Header.MD5TablePos, Header.MD5TableSize, HashTable))
+		return false;
+
+	// The pieces to check, and whether they failed
+	auto CheckCount = (Pieces != nullptr) ? (size_t)Pieces->size() : (size_t)PieceCount;
+	std::vector<uint8_t> Failed(CheckCount, 0);
+
+	// Gets the piece being checked
+	auto GetPiece = [Pieces](size_t Index) -> uint64_t
+	{
+		return (Pieces != nullptr) ? (*Pieces)[Index] : (uint64_t)Index;
+	};
+
+	// Gets the range of a piece
+	auto GetPieceRange = [&Header, DataEnd](uint64_t Piece, uint64_t& Offset, uint64_t& Size)
+	{
+		// Calculate it
+		Offset = Piece * Header.MD5PieceSize;
+		Size = (Offset < DataEnd) ? DataEnd - Offset : 0;
+		// Clamp it
+		if (Size > Header.MD5PieceSize)
+			Size = Header.MD5PieceSize;
+	};
+
+	// Hash them in parallel, each piece is read straight from the package
+	this->WorkerPool->ParallelFor(CheckCount, [&Package, &HashTable, &Failed, PieceCount, &GetPiece, &GetPieceRange](size_t Index)
+	{
+		// Grab the piece
+		auto Piece = GetPiece(Index);
+		// Pieces past the table can't be checked
+		if (Piece >= PieceCount)
+		{
+			// Failed
+			Failed[Index] = 1;
+			return;
+		}
+
+		// Calculate the range
+		uint64_t Offset = 0, Size = 0;
+		GetPieceRange(Piece, Offset, Size);
+
+		// Read it
+		IFSDataSpan PieceData;
+		// Verify
+		if (Size == 0 || !Package.ReadSpan(Offset, Size, PieceData))
+		{
+			// Failed
+			Failed[Index] = 1;
+			return;
+		}
+
+		// Hash it
+		hash_state State;
+		uint8_t PieceHash[16];
+		// Run it
+		md5_init(&State);
+		md5_process(&State, PieceData.Data, (unsigned long)PieceData.Size);
+		md5_done(&State, PieceHash);
+
+		// Compare it
+		if (std::memcmp(PieceHash, HashTable.Data + (Piece * 16), 16) != 0)
+			Failed[Index] = 1;
+	});
+
+	// Collect the results, merging neighbouring failed pieces
+	for (size_t i = 0; i < CheckCount; i++)
+	{
+		// Calculate the range
+		uint64_t Offset = 0, Size = 0;
+		GetPieceRange(GetPiece(i), Offset, Size);
+
+		// Count it
+		Result.PiecesChecked++;
+		Result.BytesChecked += Size;
+
+		// Check it
+		if (!Failed[i])
+			continue;
+
+		// Count it
+		Result.PiecesFailed++;
+
+		// Pieces past the data have no size, but still mark their place
+		if (Size == 0)
+			Size = Header.MD5PieceSize;
+
+		// Merge it with the last range if it follows it
+		if (!Result.BadRanges.empty() && Result.BadRanges.back().PackagePath == Package.GetFilePath() && (Result.BadRanges.back().Offset + Result.BadRanges.back().Size) == Offset)
+		{
+			// Extend it
+			Result.BadRanges.back().Size += Size;
+		}
+		else
+		{
+			// Add it
+			IFSVerifyRange Range;
+			// Assign
+			Range.PackagePath = Package.GetFilePath();
+			Range.Offset = Offset;
+			Range.Size = Size;
+
+			// Add it
+			Result.BadRanges.emplace_back(Range);
+		}
+	}
+
+	// Done
+	return true;
+}
+
+void IFSLib::BuildCatalog(IFSCatalog& Catalog) const
+{
+	// This covers every loaded package, wait for the ones still being mounted
+	this->WaitForMount();
+
+	// Reset it
+	Catalog.Clear();
+
+	// Prepare the private tables, the list files aren't kept once mounted, so they're parsed again
+	std::vector<std::unique_ptr<IFSPackageTable>> Tables(this->IFSPackages.size());
+
+	// Parse each package in parallel, only the tables are read, no entry is decoded
+	this->WorkerPool->ParallelFor(this->IFSPackages.size(), [this, &Tables](size_t Index)
+	{
+		// Open it again, so the mounted one is left alone
+		auto Package = std::make_unique<IFSMappedFile>();
+		// Verify
+		if (!Package->Open(this->IFSPackages[Index]->GetFilePath()))
+			return;
+
+		// Parse it, keeping the names
+		Tables[Index] = this->ParsePackageTable(std::move(Package), true, true);
+	});
+
+	// The entries already listed, names are repeated across packages
+	std::unordered_map<uint64_t, bool> Listed;
+
+	// Add them in package order
+	for (size_t i = 0; i < Tables.size(); i++)
+	{
+		// Add the package, even if it failed, so the indices match
+		auto PackageIndex = Catalog.AddPackage(this->IFSPackages[i]->GetFilePath());
+
+		// Skip failed ones
+		if (Tables[i] == nullptr)
+			continue;
+
+		// Iterate
+		for (auto& Name : Tables[i]->ListFile)
+		{
+			// Hash it the same way reads do
+			auto NameHash = Hashing::HashXXHashString(FileSystems::GetFileName(Name));
+
+			// Find the loaded entry, it's only listed under the package it was loaded from
+			IFSFileEntry FileEntry;
+			// Check it
+			if (!this->FindFileEntry(NameHash, FileEntry) || FileEntry.FilePackageIndex != (uint32_t)i)
+				continue;
+
+			// Only list it once
+			if (!Listed.emplace(NameHash, true).second)
+				continue;
+
+			// Entries that aren't downloaded yet are only counted
+			if (this->IsEntryPresent(FileEntry))
+				Catalog.AddEntry(Name.c_str(), Name.size(), PackageIndex, FileEntry);
+			else
+				Catalog.AddAbsent(FileEntry);
+		}
+
+		// Release the names
+		Tables[i].reset();
+	}
+
+	// Sort it for queries
+	Catalog.Finalize();
+}
+
+void IFSLib::SetReadAhead(uint32_t EntryCount)
+{
+	// Set it
+	this->ReadAheadEntries = EntryCount;
+}
+
+void IFSLib::SetCacheBudget(uint64_t Budget)
+{
+	// Set it
+	this->EntryCache->SetBudget(Budget);
+}
+
+void IFSLib::SetParallelDecrypt(uint32_t MinimumSize)
+{
+	this->ParallelDecryptSize = MinimumSize;
+}
+
+bool IFSLib::SetInflateBackend(IFSInflateBackend Backend)
+{
+	// Make sure it was built
+	if (!IFSInflater::IsAvailable(Backend))
+		return false;
+
+	// Set it
+	this->InflateBackend = Backend;
+
+	// Success
+	return true;
+}
+
+IFSInflateBackend IFSLib::GetInflateBackend() const
+{
+	return this->InflateBackend;
+}
+
+uint64_t IFSLib::GetAbsentReads() const
+{
+	return this->AbsentReads;
+}
+
+IFSEntryCacheStats IFSLib::GetCacheStatistics() const
+{
+	// Fetch them
+	return this->EntryCache->GetStatistics();
+}
+
+void IFSLib::PrefetchFileEntry(const IFSFileEntry& Entry) const
+{
+	// Check if it's on
+	if (this->ReadAheadEntries == 0)
+		return;
+
+	// Grab the package
+	auto& Package = *this->IFSPackages[Entry.FilePackageIndex];
+
+	// The entry itself, as one request instead of a fault per page
+	Package.Prefetch(Entry.FilePosition, Entry.CompressedSize);
+
+	// Entries are usually read in the order they're stored, and are often a similar size, so only ask for the slice the read ahead has just reached, the reads before this one asked for the rest
+	auto PrefetchOffset = Entry.FilePosition + (uint64_t)Entry.CompressedSize * this->ReadAheadEntries;
+	auto PrefetchSize = (uint64_t)Entry.CompressedSize;
+	// Limit it
+	if (PrefetchSize > IFS_READ_AHEAD_SIZE)
+		PrefetchSize = IFS_READ_AHEAD_SIZE;
+
+	// Ask for it, the package clamps it to the end
+	Package.Prefetch(PrefetchOffset, PrefetchSize);
+}
+
+bool IFSLib::DecodeFileEntry(uint32_t Nounce, const uint8_t* EntryData, uint64_t EntrySize, IFSEntrySink& Sink, IFSReadContext& Context, uint32_t OutputLimit) const
+{
+	// Read this, it's used for the IV
+	uint32_t UnpackedSize = 0;
+	std::memcpy(&UnpackedSize, EntryData + EntrySize - 4, 4);
+	auto PackedSize = (uint32_t)(EntrySize - 4);
+
+	// Only part of the entry may be wanted, then we decrypt a little at a time, to stop soon after the output is complete
+	auto OutputSize = (OutputLimit < UnpackedSize) ? OutputLimit : UnpackedSize;
+	auto Partial = (OutputSize < UnpackedSize);
+	auto DecryptStep = (Partial) ? (uint32_t)IFS_PEEK_DECRYPT_SIZE : (uint32_t)IFS_DECRYPT_BLOCK_SIZE;
+
+	// Build the IV
+	uint8_t FileIV[0x10];
+
+	// Copy data
+	std::memset(FileIV, 0, 0x10);
+	std::memcpy(FileIV, &Nounce, 4);
+	std::memcpy(FileIV + 4, &UnpackedSize, 4);
+
+	// Large entries are decrypted across the workers, a span at a time, as the blocks don't depend on each other
+	auto ParallelDecrypt = (!Partial && this->ParallelDecryptSize > 0 && PackedSize >= this->ParallelDecryptSize && this->WorkerPool->GetThreadCount() > 1);
+
+	// Prepare the sink
+	if (!Sink.Begin(OutputSize))
+		return false;
+
+	// Check if we can inflate straight into the sink, otherwise we pass it a window at a time
+	auto DirectBuffer = Sink.GetDirectBuffer();
+	// The output window, only used when we can't write directly
+	auto OutputWindow = (DirectBuffer == nullptr) ? Context.GetOutputWindow() : nullptr;
+
+	// Whole entries can be inflated in one call by the other backends, as the unpacked size is known up front
+	if (this->InflateBackend != IFSInflateBackend::ZLib && !Partial && DirectBuffer != nullptr)
+	{
+		// Grab the inflater, it's reused across reads
+		auto Inflater = Context.GetInflater(this->InflateBackend);
+		// Verify
+		if (Inflater == nullptr)
+			return false;
+
+		// Decrypt the whole entry first
+		auto DecryptedEntry = Context.GetDecryptSpanBuffer(PackedSize);
+		this->DecryptFileSpan(FileIV, EntryData, PackedSize, 0, PackedSize, DecryptedEntry, ParallelDecrypt);
+
+		// Inflate it straight into the sink
+		return Inflater->InflateBuffer(DecryptedEntry, PackedSize, DirectBuffer, OutputSize);
+	}
+
+	// Grab the inflate stream, it's reused across reads
+	auto InflateStream = Context.ResetInflate();
+	// Verify
+	if (InflateStream == nullptr)
+		return false;
+
+	// Setup the direct output
+	if (DirectBuffer != nullptr)
+	{
+		InflateStream->next_out = DirectBuffer;
+		InflateStream->avail_out = OutputSize;
+	}
+
+	// Read packed size
+	uint32_t ReadDataSize = 0;
+	// The inflate state
+	int32_t InflateResult = Z_OK;
+	// Whether or not the sink failed
+	bool SinkFailed = false;
+
+	// Working buffer, a single block, or a whole span when decrypting across the workers
+	auto DecryptedBuffer = (ParallelDecrypt) ? Context.GetDecryptSpanBuffer(IFS_PARALLEL_DECRYPT_SPAN) : Context.GetDecryptBuffer();
+
+	// We must decrypt, inflating each block as soon as it's ready
+	while (ReadDataSize < PackedSize && InflateResult != Z_STREAM_END && !SinkFailed && (!Partial || InflateStream->total_out < OutputSize))
+	{
+		// The size decrypted this step
+		uint32_t StepSize = 0;
+
+		// Check how we decrypt
+		if (ParallelDecrypt)
+		{
+			// Take a span of whole blocks
+			auto SpanStart = ReadDataSize;
+			auto SpanLeft = (PackedSize - SpanStart);
+			StepSize = (SpanLeft > IFS_PARALLEL_DECRYPT_SPAN) ? (uint32_t)IFS_PARALLEL_DECRYPT_SPAN : SpanLeft;
+
+			// Decrypt each block on its own, the output is the same as one at a time
+			this->DecryptFileSpan(FileIV, EntryData, PackedSize, SpanStart, StepSize, DecryptedBuffer, true);
+		}
+		else
+		{
+			// Each block has its own IV, find the one we're in
+			auto BlockStart = ReadDataSize - (ReadDataSize % IFS_DECRYPT_BLOCK_SIZE);
+			auto BlockLeft = (PackedSize - BlockStart);
+			auto BlockSize = (BlockLeft > IFS_DECRYPT_BLOCK_SIZE) ? (uint32_t)IFS_DECRYPT_BLOCK_SIZE : BlockLeft;
+
+			// Ask for some data, up to the end of the block
+			auto StepLeft = (BlockStart + BlockSize - ReadDataSize);
+			StepSize = (StepLeft > DecryptStep) ? DecryptStep : StepLeft;
+
+			// Start the keystream where we are in the block
+			uint8_t StepIV[0x10];
+			BuildIFSBlockIV(FileIV, BlockStart, BlockSize, StepIV);
+			AdvanceIFSCounter(StepIV, (ReadDataSize - BlockStart) / 16);
+
+			// Decrypt the step straight from the package data, the cipher keeps no state between calls
+			this->EntryCipher->DecryptCTR(StepIV, EntryData + ReadDataSize, DecryptedBuffer, StepSize);
+		}
+
+		// Advance
+		ReadDataSize += StepSize;
+
+		// Feed it to the inflate stream
+		InflateStream->next_in = DecryptedBuffer;
+		InflateStream->avail_in = StepSize;
+
+		// Inflate until the step is consumed
+		do
+		{
+			// Reset the window, never past what was asked for
+			if (DirectBuffer == nullptr)
+			{
+				InflateStream->next_out = OutputWindow;
+				InflateStream->avail_out = (Partial && (OutputSize - InflateStream->total_out) < 0x10000) ? (uint32_t)(OutputSize - InflateStream->total_out) : 0x10000;
+			}
+
+			// Remember the window size
+			auto WindowSize = InflateStream->avail_out;
+
+			// Inflate what we can
+			InflateResult = inflate(InflateStream, Z_NO_FLUSH);
+
+			// Check for errors, a buffer error just means no progress could be made
+			if (InflateResult != Z_OK && InflateResult != Z_STREAM_END && InflateResult != Z_BUF_ERROR)
+				break;
+
+			// Pass the window to the sink
+			if (DirectBuffer == nullptr && InflateStream->avail_out < WindowSize)
+				SinkFailed = !Sink.Write(OutputWindow, WindowSize - InflateStream->avail_out);
+
+		} while (InflateResult == Z_OK && !SinkFailed && InflateStream->avail_in > 0 && (DirectBuffer == nullptr || InflateStream->avail_out > 0) && (!Partial || InflateStream->total_out < OutputSize));
+
+		// Stop on errors
+		if (InflateResult != Z_OK && InflateResult != Z_STREAM_END && InflateResult != Z_BUF_ERROR)
+			break;
+	}
+
+	// Grab the output size, the stream is reset on the next read
+	auto InflatedSize = InflateStream->total_out;
+
+	// Make sure we got what was asked for
+	if (Partial)
+		return (InflatedSize >= OutputSize && !SinkFailed);
+
+	// Make sure we got the whole entry
+	return ((InflateResult == Z_STREAM_END || InflatedSize == UnpackedSize) && !SinkFailed);
+}
+
+void IFSLib::DecryptFileSpan(const uint8_t* FileIV, const uint8_t* EntryData, uint32_t PackedSize, uint32_t SpanStart, uint32_t SpanSize, uint8_t* Output, bool Parallel) const
+{
+	// Decrypts a single block into its place in the span
+	auto DecryptBlock = [this, FileIV, EntryData, PackedSize, SpanStart, Output](size_t Index)
+	{
+		// Find the block
+		auto BlockStart = SpanStart + (uint32_t)(Index * IFS_DECRYPT_BLOCK_SIZE);
+		auto BlockLeft = (PackedSize - BlockStart);
+		auto BlockSize = (BlockLeft > IFS_DECRYPT_BLOCK_SIZE) ? (uint32_t)IFS_DECRYPT_BLOCK_SIZE : BlockLeft;
+
+		// Build its IV
+		uint8_t BlockIV[0x10];
+		BuildIFSBlockIV(FileIV, BlockStart, BlockSize, BlockIV);
+
+		// Decrypt it
+		this->EntryCipher->DecryptCTR(BlockIV, EntryData + BlockStart, Output + (BlockStart - SpanStart), BlockSize);
+	};
+
+	// The count of blocks in the span
+	auto BlockCount = (size_t)((SpanSize + IFS_DECRYPT_BLOCK_SIZE - 1) / IFS_DECRYPT_BLOCK_SIZE);
+
+	// Each block has its own IV, so they don't depend on each other
+	if (Parallel)
+	{
+		this->WorkerPool->ParallelFor(BlockCount, DecryptBlock);
+	}
+	else
+	{
+		for (size_t i = 0; i < BlockCount; i++)
+			DecryptBlock(i);
+	}
 }
\ No newline at end of file
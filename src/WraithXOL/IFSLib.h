@@ -1,10 +1,16 @@
 #pragma once
 
 #include <cstdint>
+#include <cstring>
 #include <memory>
 #include <vector>
 #include <unordered_map>
 #include <string>
+#include <functional>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
 
 // Configure LibTom
 #define LTM_DESC
@@ -12,17 +18,110 @@
 // Encryption
 #include "tomcrypt.h"
 
-// An entry in the IFS package
-struct IFSFileEntry
+// We need the mapped package, file table, cipher, worker, sink, context and cache classes
+#include "IFSMappedFile.h"
+#include "IFSFileTable.h"
+#include "IFSCipher.h"
+#include "IFSThreadPool.h"
+#include "IFSEntrySink.h"
+#include "IFSReadContext.h"
+#include "IFSEntryCache.h"
+#include "IFSDownloadBitmap.h"
+
+// The index used to skip parsing unchanged packages
+class IFSIndexCache;
+// The listing of loaded entries
+class IFSCatalog;
+
+// A resolved list file entry from a package, waiting to be merged
+struct IFSPackageEntry
+{
+	uint64_t EntryHash;
+	IFSFileEntry Entry;
+	bool HiRes;
+
+	IFSPackageEntry(uint64_t Hash, const IFSFileEntry& FileEntry, bool IsHiRes) : EntryHash(Hash), Entry(FileEntry), HiRes(IsHiRes) { }
+};
+
+// A package parsed into a private table, before it's merged into the loaded files
+struct IFSPackageTable
+{
+	// The mapped package
+	std::unique_ptr<IFSMappedFile> Package;
+	// The resolved entries, in list file order
+	std::vector<IFSPackageEntry> Entries;
+	// The list file names, if requested
+	std::vector<std::string> ListFile;
+};
+
+// A range of a package that failed verification
+struct IFSVerifyRange
+{
+	// The path of the package
+	std::string PackagePath;
+	// The start of the range
+	uint64_t Offset;
+	// The size of the range
+	uint64_t Size;
+};
+
+// The result of checking packages against their MD5 tables
+struct IFSVerifyResult
 {
-	uint32_t FilePackageIndex;
-	uint64_t FilePosition;
-	uint64_t FileSize;
-	uint64_t CompressedSize;
-	uint64_t Flags;
+	// The count of pieces checked
+	uint64_t PiecesChecked;
+	// The count of pieces that didn't match
+	uint64_t PiecesFailed;
+	// The count of bytes hashed
+	uint64_t BytesChecked;
+	// The time taken, in seconds
+	double Seconds;
+
+	// The ranges that didn't match, neighbouring pieces are merged
+	std::vector<IFSVerifyRange> BadRanges;
+	// The requested entries backed by a range that didn't match (VerifyFileEntries only)
+	std::vector<size_t> BadEntries;
+
+	IFSVerifyResult() : PiecesChecked(0), PiecesFailed(0), BytesChecked(0), Seconds(0) { }
+
+	// Gets the throughput in MB/s
+	double GetThroughput() const { return (Seconds > 0) ? ((double)BytesChecked / (1024.0 * 1024.0)) / Seconds : 0; }
+};
+
+// An entry resolved by IFSLib::Resolve, reads through it skip the name work (Only valid until a loaded package replaces the entry)
+class IFSEntryHandle
+{
+public:
+	IFSEntryHandle() : EntryHash(0), Nounce(0), LoadGeneration(0), Found(false), Present(false) { std::memset(&Entry, 0, sizeof(Entry)); }
+
+	// Whether or not the entry was found
+	bool IsValid() const { return this->Found; }
+	// Whether or not the entry's data is downloaded, only these can be read
+	bool IsPresent() const { return this->Present; }
+	// Gets the unpacked size
+	uint64_t GetFileSize() const { return this->Entry.FileSize; }
+	// Gets the packed size, as stored
+	uint64_t GetCompressedSize() const { return this->Entry.CompressedSize; }
+
+private:
+	// Only the library fills these in
+	friend class IFSLib;
+
+	// The hash of the file name, the cache key
+	uint64_t EntryHash;
+	// The entry, with its package
+	IFSFileEntry Entry;
+	// The start of the IV, from the file name
+	uint32_t Nounce;
+	// The loaded packages this was resolved against
+	uint32_t LoadGeneration;
+	// Whether or not it was found
+	bool Found;
+	// Whether or not its data is on disk
+	bool Present;
 };
 
-// A class that handles reading from IFS packages
+// A class that handles reading from IFS packages, entries may be read from many threads at once, as long as no packages are being loaded (Other than by MountIFSPathAsync)
 class IFSLib
 {
 public:
@@ -34,27 +133,164 @@ public:
 	void AddPackage(const std::string& PackagePath);
 	// Parse and load an IFS file with the list file
 	std::vector<std::string> ParsePackage(const std::string& PackagePath);
-	// Parse and load all available IFS packages in the path
-	void MountIFSPath(const std::string& IFSPath);
+	// Parse and load all available IFS packages in the path, using and updating the index, if provided (Audio entries are only loaded if asked, without the index)
+	void MountIFSPath(const std::string& IFSPath, const std::string& IndexPath = "", bool Audio = false);
+	// Starts mounting the path in the background, once every package is parsed, lookups are served as soon as no package left to merge has a hires copy of the name, until then they wait
+	void MountIFSPathAsync(const std::string& IFSPath, const std::string& IndexPath = "");
+
+	// Whether or not packages are still being mounted in the background
+	bool IsMounting() const;
+	// Waits for every package being mounted in the background
+	void WaitForMount() const;
 
 	// Gets the count of entries
 	size_t GetLoadedEntries();
 
 	// Attemps to read an entry (Name is the file name, with extension)
-	std::unique_ptr<uint8_t[]> ReadFileEntry(const std::string& Name, uint32_t& ResultSize);
+	std::unique_ptr<uint8_t[]> ReadFileEntry(const std::string& Name, uint32_t& ResultSize) const;
+	// Attemps to read an entry, streaming it into the sink as it's decoded (Name is the file name, with extension)
+	bool ReadFileEntry(const std::string& Name, IFSEntrySink& Sink) const;
+	// Attemps to read an entry into the context's reused buffers, see IFSReadContext::GetData (Name is the file name, with extension)
+	bool ReadFileEntry(const std::string& Name, IFSReadContext& Context) const;
+	// Reads only the start of an entry, decrypting and inflating no more than it takes to produce MaxBytes (Name is the file name, with extension)
+	std::unique_ptr<uint8_t[]> PeekFileEntry(const std::string& Name, uint32_t MaxBytes, uint32_t& ResultSize) const;
+	// Reads only the start of an entry into the context's reused buffers, see IFSReadContext::GetData (Name is the file name, with extension)
+	bool PeekFileEntry(const std::string& Name, uint32_t MaxBytes, IFSReadContext& Context) const;
+	// Resolves an entry once, so it can be read or peeked repeatedly without the name lookup (Name is the file name, with extension)
+	IFSEntryHandle Resolve(const std::string& Name) const;
+	// Reads a resolved entry
+	std::unique_ptr<uint8_t[]> ReadFileEntry(const IFSEntryHandle& Handle, uint32_t& ResultSize) const;
+	// Reads a resolved entry, streaming it into the sink as it's decoded
+	bool ReadFileEntry(const IFSEntryHandle& Handle, IFSEntrySink& Sink) const;
+	// Reads a resolved entry into the context's reused buffers, see IFSReadContext::GetData
+	bool ReadFileEntry(const IFSEntryHandle& Handle, IFSReadContext& Context) const;
+	// Reads only the start of a resolved entry
+	std::unique_ptr<uint8_t[]> PeekFileEntry(const IFSEntryHandle& Handle, uint32_t MaxBytes, uint32_t& ResultSize) const;
+	// Reads only the start of a resolved entry into the context's reused buffers, see IFSReadContext::GetData
+	bool PeekFileEntry(const IFSEntryHandle& Handle, uint32_t MaxBytes, IFSReadContext& Context) const;
+
+	// Reads a batch of entries in package order, merging nearby entries into sequential reads, each entry is passed to the callback once decoded (Missing entries are skipped, returns the count skipped as they aren't downloaded yet)
+	size_t ReadFileEntries(const std::vector<std::string>& Names, const std::function<void(size_t Index, std::unique_ptr<uint8_t[]>& Data, uint32_t DataSize)>& Callback) const;
+
+	// Reads a batch of entries in package order without decoding them, mapped data is valid for the life of the library, otherwise only during the callback (Missing entries are skipped, returns the count skipped as they aren't downloaded yet)
+	size_t ReadPackedEntries(const std::vector<std::string>& Names, const std::function<void(size_t Index, const uint8_t* Data, uint64_t DataSize, bool Mapped)>& Callback) const;
+	// Decrypts and inflates an entry read with ReadPackedEntries into the sink, safe to call from multiple threads with their own context
+	bool DecodePackedEntry(const std::string& Name, const uint8_t* Data, uint64_t DataSize, IFSEntrySink& Sink, IFSReadContext& Context) const;
+
+	// Checks every piece of a package against its MD5 table, in parallel, returns false if it couldn't be checked (No table, or not an IFS package)
+	bool VerifyPackage(const std::string& PackagePath, IFSVerifyResult& Result) const;
+	// Checks only the pieces backing the given entries in the loaded packages, returns false if any of them couldn't be checked
+	bool VerifyFileEntries(const std::vector<std::string>& Names, IFSVerifyResult& Result) const;
+
+	// Lists every loaded entry with its package, position, sizes and flags, by reading the package tables only (Entries that aren't downloaded yet are only counted)
+	void BuildCatalog(IFSCatalog& Catalog) const;
+
+	// Sets how many entries past the current one are prefetched from disk while it's decoded, 0 turns it off (Set before reading)
+	void SetReadAhead(uint32_t EntryCount);
+
+	// Sets the packed size from which an entry's blocks are decrypted across the workers, 0 turns it off (Set before reading)
+	void SetParallelDecrypt(uint32_t MinimumSize);
+
+	// Sets the inflate backend, returns false if it wasn't built, zlib streams entries as they're decrypted, the others inflate whole entries (Set before reading)
+	bool SetInflateBackend(IFSInflateBackend Backend);
+	// Gets the inflate backend
+	IFSInflateBackend GetInflateBackend() const;
+
+	// Sets the byte budget for keeping decoded entries, so ones read again skip decoding, 0 turns it off (Off by default)
+	void SetCacheBudget(uint64_t Budget);
+	// Gets the decoded entry cache counters
+	IFSEntryCacheStats GetCacheStatistics() const;
+
+	// Gets the count of reads refused because the entry isn't downloaded yet, single and batched
+	uint64_t GetAbsentReads() const;
 
 private:
 
-	// A list of loaded IFS files
-	std::unordered_map<uint64_t, IFSFileEntry> IFSFiles;
-	// A list of loaded IFSPackage paths
-	std::vector<std::string> IFSPackages;
+	// A table of loaded IFS files
+	IFSFileTable IFSFiles;
+	// A list of loaded IFSPackages, mapped for the life of the library
+	std::vector<std::unique_ptr<IFSMappedFile>> IFSPackages;
+	// The download bitmap of each loaded package, only set for partially downloaded ones
+	std::vector<std::unique_ptr<IFSDownloadBitmap>> PackageBitmaps;
+
+	// The mount index, while lookups are served from it
+	std::unique_ptr<IFSIndexCache> IndexCache;
+
+	// Parses an opened package into a private table, safe to call from multiple threads
+	std::unique_ptr<IFSPackageTable> ParsePackageTable(std::unique_ptr<IFSMappedFile> Package, bool Audio, bool KeepListFile) const;
+	// Merges a parsed package into the loaded files, resolving hires overrides
+	void MergePackageTable(IFSPackageTable& Table);
+	// Opens, parses and merges the packages, in path order, using and updating the index, if provided
+	void MountPackages(const std::vector<std::string>& IFSFiles, const std::string& IndexPath, bool Audio);
+	// Marks the mount complete, waking the lookups waiting on it
+	void FinishMount();
+	// Waits for the background mount to exit, before packages are loaded any other way
+	void JoinMount();
+
+	// Checks pieces of a package against its MD5 table, all of them if none are given (Pieces must be sorted)
+	bool VerifyPackagePieces(const IFSMappedFile& Package, const std::vector<uint64_t>* Pieces, IFSVerifyResult& Result) const;
+
+	// Resolves an entry from the file name alone
+	IFSEntryHandle ResolveFileName(const std::string& NameString) const;
+	// Checks that a handle was resolved against the loaded packages, and can be read
+	bool IsCurrentHandle(const IFSEntryHandle& Handle) const;
+	// Checks that an entry's data is on disk
+	bool IsEntryPresent(const IFSFileEntry& Entry) const;
+	// Checks that a decoded entry can be cached, nothing may have replaced it since it was resolved
+	bool CanKeepEntry(const IFSEntryHandle& Handle) const;
+
+	// Decrypts and inflates an entry's data into the sink, stopping once the output limit is reached (The nounce is from the file name)
+	bool DecodeFileEntry(uint32_t Nounce, const uint8_t* EntryData, uint64_t EntrySize, IFSEntrySink& Sink, IFSReadContext& Context, uint32_t OutputLimit = 0xFFFFFFFF) const;
+	// Decrypts a span of whole blocks of an entry, across the workers if asked to
+	void DecryptFileSpan(const uint8_t* FileIV, const uint8_t* EntryData, uint32_t PackedSize, uint32_t SpanStart, uint32_t SpanSize, uint8_t* Output, bool Parallel) const;
+
+	// Asks the package to start reading an entry, and the entries likely to be read after it
+	void PrefetchFileEntry(const IFSFileEntry& Entry) const;
+
+	// Finds a loaded entry, from the index if it's serving lookups
+	bool FindFileEntry(uint64_t EntryHash, IFSFileEntry& Result) const;
+	// Finds an entry while packages are being mounted, waiting for them until it's found and nothing left to merge can replace it, or none are left
+	bool FindPendingFileEntry(uint64_t EntryHash, IFSFileEntry& Result) const;
+	// Stops serving lookups from the index, loading its entries so new packages can be merged
+	void DetachIndexCache();
+
+	// The decoded entries, keyed by the name hash
+	std::unique_ptr<IFSEntryCache> EntryCache;
+
+	// The entry cipher, scheduled once and never modified
+	std::unique_ptr<IFSCipher> EntryCipher;
+
+	// The workers used to load packages, and decrypt large entries
+	std::unique_ptr<IFSThreadPool> WorkerPool;
+
+	// The count of entries to prefetch ahead of the one being read
+	uint32_t ReadAheadEntries;
+	// The packed size from which entries are decrypted across the workers
+	uint32_t ParallelDecryptSize;
+	// The inflate backend
+	IFSInflateBackend InflateBackend;
+
+	// Bumped each time a merged package replaces entries, so older handles are refused
+	std::atomic<uint32_t> LoadGeneration;
+
+	// The background mount
+	std::thread MountThread;
+	// Whether or not packages are still being merged by it
+	std::atomic<bool> MountPending;
+	// Guards the loaded files while it merges
+	mutable std::mutex MountMutex;
+	// Signaled as each package is merged
+	mutable std::condition_variable MountSignal;
+	// The count of packages it hasn't parsed yet, any of them may replace a loaded entry (Guarded by the mount mutex)
+	size_t UnparsedPackages;
+	// The hires entries of the packages it parsed, but hasn't merged yet, with the count of packages holding each (Guarded by the mount mutex)
+	std::unordered_map<uint64_t, uint32_t> PendingHiRes;
 
-	// Loads a package, inserting into the given listfile
-	void LoadPackageInternal(const std::string& PackagePath, std::vector<std::string>& LoadedListFile, bool Audio = false);
+	// The count of reads refused as the entry isn't downloaded yet
+	mutable std::atomic<uint64_t> AbsentReads;
 
-	// The encryption key base
-	symmetric_CTR EncryptionKey;
+	// Whether or not list file paths use the fused hashes, they're checked against the reference ones first
+	bool FusedPathHash;
 
 	// Initialize the IFS code, and setup the encryption
 	void Initialize();
@@ -0,0 +1,76 @@
+#include "stdafx.h"
+
+// The class we are implementing
+#include "IFSListFileReader.h"
+
+// We need the following std classes
+#include <cstring>
+
+// Whether or not the character is trimmed from a line
+bool IsListFileSpace(char Value)
+{
+	return (Value == ' ' || Value == '\t' || Value == '\r' || Value == '\n' || Value == '\v' || Value == '\f');
+}
+
+IFSListFileReader::IFSListFileReader(const char* Buffer, size_t BufferSize)
+{
+	// Assign
+	this->Buffer = Buffer;
+	this->BufferEnd = Buffer + BufferSize;
+}
+
+IFSListFileReader::~IFSListFileReader()
+{
+	// Default
+}
+
+bool IFSListFileReader::ReadLine(IFSListFileLine& Result)
+{
+	// Read until we have a line with content
+	while (this->Buffer < this->BufferEnd)
+	{
+		// Find the end of the line
+		auto LineEnd = (const char*)std::memchr(this->Buffer, '\n', this->BufferEnd - this->Buffer);
+		// The last line may not have one
+		if (LineEnd == nullptr)
+			LineEnd = this->BufferEnd;
+
+		// Grab the line, and advance past it
+		auto LineStart = this->Buffer;
+		this->Buffer = (LineEnd < this->BufferEnd) ? LineEnd + 1 : this->BufferEnd;
+
+		// Trim both ends
+		while (LineStart < LineEnd && IsListFileSpace(*LineStart))
+			LineStart++;
+		while (LineEnd > LineStart && IsListFileSpace(*(LineEnd - 1)))
+			LineEnd--;
+
+		// Skip empty lines
+		if (LineStart == LineEnd)
+			continue;
+
+		// Find the file name, after the last separator
+		auto NameStart = LineEnd;
+		while (NameStart > LineStart && *(NameStart - 1) != '/' && *(NameStart - 1) != '\\')
+			NameStart--;
+
+		// Assign the line
+		Result.Line = LineStart;
+		Result.LineLength = (size_t)(LineEnd - LineStart);
+		Result.Name = NameStart;
+		Result.NameLength = (size_t)(LineEnd - NameStart);
+		Result.HiRes = (Result.LineLength >= 6 && std::memcmp(LineStart, "hires/", 6) == 0);
+
+		// Success
+		return true;
+	}
+
+	// Done
+	return false;
+}
+
+bool IFSListFileReader::EndsWith(const IFSListFileLine& Line, const char* Suffix, size_t SuffixLength)
+{
+	// Compare the tail
+	return (Line.LineLength >= SuffixLength && std::memcmp(Line.Line + Line.LineLength - SuffixLength, Suffix, SuffixLength) == 0);
+}
\ No newline at end of file
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+
+// A line of the list file, pointing into the list file buffer
+struct IFSListFileLine
+{
+	// The trimmed line
+	const char* Line;
+	size_t LineLength;
+
+	// The file name part of the line
+	const char* Name;
+	size_t NameLength;
+
+	// Whether or not the line is under "hires/"
+	bool HiRes;
+};
+
+// A class that tokenizes a list file in place, without allocating
+class IFSListFileReader
+{
+public:
+	// Constructors
+	IFSListFileReader(const char* Buffer, size_t BufferSize);
+	~IFSListFileReader();
+
+	// Reads the next non-empty line, returns false once the buffer is exhausted
+	bool ReadLine(IFSListFileLine& Result);
+
+	// Whether or not a line ends with the given suffix (Case sensitive)
+	static bool EndsWith(const IFSListFileLine& Line, const char* Suffix, size_t SuffixLength);
+
+private:
+	// The buffer we are reading
+	const char* Buffer;
+	// The end of the buffer
+	const char* BufferEnd;
+};
\ No newline at end of file
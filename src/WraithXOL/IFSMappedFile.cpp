@@ -0,0 +1,245 @@
+#include "stdafx.h"
+
+// The class we are implementing
+#include "IFSMappedFile.h"
+
+// We need the Win32 file api
+#include <Windows.h>
+
+// A range to prefetch, the same as WIN32_MEMORY_RANGE_ENTRY, which older SDKs don't have
+struct IFSPrefetchRange
+{
+	PVOID VirtualAddress;
+	SIZE_T NumberOfBytes;
+};
+
+// PrefetchVirtualMemory, it's only available on Windows 8 and later, so it's resolved at runtime
+typedef BOOL(WINAPI* IFSPrefetchVirtualMemory)(HANDLE Process, ULONG_PTR NumberOfEntries, IFSPrefetchRange* VirtualAddresses, ULONG Flags);
+
+IFSMappedFile::IFSMappedFile()
+{
+	// Defaults
+	this->FileSize = 0;
+	this->LastWriteTime = 0;
+	this->FileHandle = INVALID_HANDLE_VALUE;
+	this->MappingHandle = NULL;
+	this->MappedView = nullptr;
+	this->PrefetchRoutine = nullptr;
+}
+
+IFSMappedFile::~IFSMappedFile()
+{
+	// Clean up
+	this->Close();
+}
+
+bool IFSMappedFile::Open(const std::string& FilePath)
+{
+	// Clean up any previous package
+	this->Close();
+
+	// Open the package (Sharing mode, the game may have it open!)
+	this->FileHandle = CreateFileA(FilePath.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	// Verify
+	if (this->FileHandle == INVALID_HANDLE_VALUE)
+		return false;
+
+	// Fetch the size
+	LARGE_INTEGER Size;
+	// Verify
+	if (!GetFileSizeEx((HANDLE)this->FileHandle, &Size))
+	{
+		// Failed
+		this->Close();
+		return false;
+	}
+
+	// Fetch the last write time
+	FILETIME WriteTime;
+	// Verify
+	if (!GetFileTime((HANDLE)this->FileHandle, NULL, NULL, &WriteTime))
+	{
+		// Failed
+		this->Close();
+		return false;
+	}
+
+	// Set info
+	this->FilePath = FilePath;
+	this->FileSize = (uint64_t)Size.QuadPart;
+	this->LastWriteTime = ((uint64_t)WriteTime.dwHighDateTime << 32) | WriteTime.dwLowDateTime;
+
+	// Attempt to map the entire package, this can fail for large packages in 32bit, where we fall back to positional reads
+	if (this->FileSize > 0 && this->FileSize <= (uint64_t)SIZE_MAX)
+	{
+		// Create the mapping
+		this->MappingHandle = CreateFileMappingA((HANDLE)this->FileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+
+		// Map the view
+		if (this->MappingHandle != NULL)
+			this->MappedView = (const uint8_t*)MapViewOfFile((HANDLE)this->MappingHandle, FILE_MAP_READ, 0, 0, 0);
+
+		// Check if we need to fall back
+		if (this->MappedView == nullptr && this->MappingHandle != NULL)
+		{
+			// Close the mapping, we don't need it
+			CloseHandle((HANDLE)this->MappingHandle);
+			this->MappingHandle = NULL;
+		}
+	}
+
+	// Resolve the prefetch routine, it only works on mapped packages
+	if (this->MappedView != nullptr)
+		this->PrefetchRoutine = (void*)GetProcAddress(GetModuleHandleA("kernel32.dll"), "PrefetchVirtualMemory");
+
+	// Success
+	return true;
+}
+
+void IFSMappedFile::Close()
+{
+	// Unmap the view
+	if (this->MappedView != nullptr)
+		UnmapViewOfFile(this->MappedView);
+	// Close the mapping
+	if (this->MappingHandle != NULL)
+		CloseHandle((HANDLE)this->MappingHandle);
+	// Close the file
+	if (this->FileHandle != INVALID_HANDLE_VALUE)
+		CloseHandle((HANDLE)this->FileHandle);
+
+	// Reset
+	this->FileSize = 0;
+	this->LastWriteTime = 0;
+	this->FileHandle = INVALID_HANDLE_VALUE;
+	this->MappingHandle = NULL;
+	this->MappedView = nullptr;
+	this->PrefetchRoutine = nullptr;
+}
+
+bool IFSMappedFile::ReadSpan(uint64_t Offset, uint64_t Size, IFSDataSpan& Result) const
+{
+	// Reset the result
+	Result.Data = nullptr;
+	Result.Size = 0;
+	Result.Storage.reset();
+
+	// Verify the region is within the package
+	if (Offset > this->FileSize || Size > (this->FileSize - Offset))
+		return false;
+
+	// Check if we're mapped, if so, just point into the view
+	if (this->MappedView != nullptr)
+	{
+		// Assign the region
+		Result.Data = this->MappedView + Offset;
+		Result.Size = Size;
+
+		// Success
+		return true;
+	}
+
+	// We must copy the region out of the package
+	Result.Storage = std::make_unique<uint8_t[]>((size_t)Size);
+
+	// Read it
+	if (!this->ReadData(Offset, Size, Result.Storage.get()))
+	{
+		// Failed
+		Result.Storage.reset();
+		return false;
+	}
+
+	// Assign the region
+	Result.Data = Result.Storage.get();
+	Result.Size = Size;
+
+	// Success
+	return true;
+}
+
+bool IFSMappedFile::ReadData(uint64_t Offset, uint64_t Size, uint8_t* Buffer) const
+{
+	// Verify the region is within the package
+	if (this->FileHandle == INVALID_HANDLE_VALUE || Offset > this->FileSize || Size > (this->FileSize - Offset))
+		return false;
+
+	// Check if we're mapped, if so, just copy from the view
+	if (this->MappedView != nullptr)
+	{
+		// Copy it
+		std::memcpy(Buffer, this->MappedView + Offset, (size_t)Size);
+
+		// Success
+		return true;
+	}
+
+	// Read in chunks, positional reads don't touch a shared file pointer
+	while (Size > 0)
+	{
+		// Calculate the chunk size
+		auto ChunkSize = (DWORD)((Size > 0x10000000) ? 0x10000000 : Size);
+
+		// Setup the position
+		OVERLAPPED Position;
+		// Clear it
+		std::memset(&Position, 0, sizeof(Position));
+		// Set the offset
+		Position.Offset = (DWORD)(Offset & 0xFFFFFFFF);
+		Position.OffsetHigh = (DWORD)(Offset >> 32);
+
+		// Read the chunk
+		DWORD ReadResult = 0;
+		// Verify
+		if (!ReadFile((HANDLE)this->FileHandle, Buffer, ChunkSize, &ReadResult, &Position) || ReadResult != ChunkSize)
+			return false;
+
+		// Advance
+		Buffer += ChunkSize;
+		Offset += ChunkSize;
+		Size -= ChunkSize;
+	}
+
+	// Success
+	return true;
+}
+
+bool IFSMappedFile::Prefetch(uint64_t Offset, uint64_t Size) const
+{
+	// We can only prefetch a mapped package
+	if (this->PrefetchRoutine == nullptr || Offset >= this->FileSize)
+		return false;
+
+	// Clamp the region to the package
+	if (Size > (this->FileSize - Offset))
+		Size = this->FileSize - Offset;
+
+	// Setup the range
+	IFSPrefetchRange Range;
+	// Assign it
+	Range.VirtualAddress = (PVOID)(this->MappedView + Offset);
+	Range.NumberOfBytes = (SIZE_T)Size;
+
+	// Queue the reads, this returns once they are issued, not once they complete
+	return (((IFSPrefetchVirtualMemory)this->PrefetchRoutine)(GetCurrentProcess(), 1, &Range, 0) != FALSE);
+}
+
+bool IFSMappedFile::IsMapped() const
+{
+	return (this->MappedView != nullptr);
+}
+
+uint64_t IFSMappedFile::GetSize() const
+{
+	return this->FileSize;
+}
+
+uint64_t IFSMappedFile::GetLastWriteTime() const
+{
+	return this->LastWriteTime;
+}
+
+const std::string& IFSMappedFile::GetFilePath() const
+{
+	return this->FilePath;
+}
\ No newline at end of file
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+// A read-only region of an IFS package
+struct IFSDataSpan
+{
+	// The start of the region
+	const uint8_t* Data;
+	// The size of the region
+	uint64_t Size;
+
+	// Backing storage, only used when the package could not be mapped
+	std::unique_ptr<uint8_t[]> Storage;
+
+	IFSDataSpan() : Data(nullptr), Size(0) { }
+};
+
+// A class that maps an IFS package into memory once, for the life of the package
+class IFSMappedFile
+{
+public:
+	// Constructors
+	IFSMappedFile();
+	~IFSMappedFile();
+
+	// Opens and maps the package, falls back to positional reads if it can't be mapped
+	bool Open(const std::string& FilePath);
+	// Unmaps and closes the package
+	void Close();
+
+	// Gets a read-only span of the package, zero-copy when the package is mapped
+	bool ReadSpan(uint64_t Offset, uint64_t Size, IFSDataSpan& Result) const;
+	// Copies a region of the package into the given buffer
+	bool ReadData(uint64_t Offset, uint64_t Size, uint8_t* Buffer) const;
+	// Asks the system to start reading a region of the package in the background, returns false if it can't (Not mapped, or before Windows 8)
+	bool Prefetch(uint64_t Offset, uint64_t Size) const;
+
+	// Reads a structure from the package
+	template <class T>
+	bool Read(uint64_t Offset, T& Result) const
+	{
+		// Copy out the structure
+		return this->ReadData(Offset, sizeof(T), (uint8_t*)&Result);
+	}
+
+	// Whether or not the package is mapped into memory
+	bool IsMapped() const;
+	// Gets the size of the package
+	uint64_t GetSize() const;
+	// Gets the last write time of the package
+	uint64_t GetLastWriteTime() const;
+	// Gets the path of the package
+	const std::string& GetFilePath() const;
+
+private:
+	// The path of the package
+	std::string FilePath;
+	// The size of the package
+	uint64_t FileSize;
+	// The last write time of the package
+	uint64_t LastWriteTime;
+
+	// The package file handle
+	void* FileHandle;
+	// The file mapping handle
+	void* MappingHandle;
+	// The mapped view of the package, null when not mapped
+	const uint8_t* MappedView;
+	// The system prefetch routine, null when not available
+	void* PrefetchRoutine;
+
+	// Prevent copies, we own the handles
+	IFSMappedFile(const IFSMappedFile&);
+	IFSMappedFile& operator=(const IFSMappedFile&);
+};
\ No newline at end of file
@@ -0,0 +1,428 @@
+#include "stdafx.h"
+
+// The class we are implementing
+#include "IFSPathHash.h"
+
+// We need the following std classes
+#include <cstring>
+
+// We need SSE2 for the lanes
+#include <emmintrin.h>
+
+// The count of lanes in a batch
+#define IFS_PATH_HASH_LANES 4
+// Paths up to this size are normalized 16 bytes at a time on the stack, longer ones a word at a time
+#define IFS_PATH_HASH_STACK 0x200
+
+// XXHash64 primes
+#define IFS_XXH_PRIME1 0x9E3779B185EBCA87ULL
+#define IFS_XXH_PRIME2 0xC2B2AE3D27D4EB4FULL
+#define IFS_XXH_PRIME3 0x165667B19E3779F9ULL
+#define IFS_XXH_PRIME4 0x85EBCA77C2B2AE63ULL
+#define IFS_XXH_PRIME5 0x27D4EB2F165667C5ULL
+
+// Rotates a 32bit value left
+inline uint32_t RotateLeft32(uint32_t Value, uint32_t Shift)
+{
+	return (Value << Shift) | (Value >> (32 - Shift));
+}
+
+// Rotates a 64bit value left
+inline uint64_t RotateLeft64(uint64_t Value, uint32_t Shift)
+{
+	return (Value << Shift) | (Value >> (64 - Shift));
+}
+
+// Lowercases the ascii letters of 4 packed bytes, and replaces '/' with '\\', matching ToLower then Replace
+inline uint32_t NormalizePathWord(uint32_t Value)
+{
+	// Flag 'A'-'Z', the high bit of each byte is set when it's in range
+	auto Low = Value & 0x7F7F7F7F;
+	auto Upper = ~Value & ((Low + 0x3F3F3F3F) ^ (Low + 0x25252525)) & 0x80808080;
+	// Lowercase them
+	Value |= (Upper >> 2);
+
+	// Flag '/', the high bit of each byte is set when it matches
+	auto Slash = Value ^ 0x2F2F2F2F;
+	auto IsSlash = ~(((Slash & 0x7F7F7F7F) + 0x7F7F7F7F) | Slash) & 0x80808080;
+	// Swap them for '\\'
+	Value ^= (IsSlash >> 7) * ('/' ^ '\\');
+
+	// Return it
+	return Value;
+}
+
+// Loads a normalized word
+inline uint32_t LoadPathWord(const char* Value)
+{
+	uint32_t Result;
+	std::memcpy(&Result, Value, sizeof(Result));
+	return NormalizePathWord(Result);
+}
+
+// Loads a normalized partial block, zero-filled past the given length
+inline void LoadPathTail(const char* Value, size_t Length, uint32_t* Block)
+{
+	// Read the block
+	uint8_t Buffer[12] = { 0 };
+	std::memcpy(Buffer, Value, Length);
+
+	// Normalize it
+	Block[0] = LoadPathWord((const char*)Buffer);
+	Block[1] = LoadPathWord((const char*)Buffer + 4);
+	Block[2] = LoadPathWord((const char*)Buffer + 8);
+}
+
+// The lookup3 mix
+inline void MixLookup(uint32_t& A, uint32_t& B, uint32_t& C)
+{
+	A -= C; A ^= RotateLeft32(C, 4); C += B;
+	B -= A; B ^= RotateLeft32(A, 6); A += C;
+	C -= B; C ^= RotateLeft32(B, 8); B += A;
+	A -= C; A ^= RotateLeft32(C, 16); C += B;
+	B -= A; B ^= RotateLeft32(A, 19); A += C;
+	C -= B; C ^= RotateLeft32(B, 4); B += A;
+}
+
+// The lookup3 final
+inline void FinalLookup(uint32_t& A, uint32_t& B, uint32_t& C)
+{
+	C ^= B; C -= RotateLeft32(B, 14);
+	A ^= C; A -= RotateLeft32(C, 11);
+	B ^= A; B -= RotateLeft32(A, 25);
+	C ^= B; C -= RotateLeft32(B, 16);
+	A ^= C; A -= RotateLeft32(C, 4);
+	B ^= A; B -= RotateLeft32(A, 14);
+	C ^= B; C -= RotateLeft32(B, 24);
+}
+
+// Hashes the remaining blocks of a lookup hash, from the given state
+uint64_t FinishLookup(const char* Value, size_t Length, uint32_t A, uint32_t B, uint32_t C)
+{
+	// All but the last block
+	while (Length > 12)
+	{
+		// Mix it
+		A += LoadPathWord(Value);
+		B += LoadPathWord(Value + 4);
+		C += LoadPathWord(Value + 8);
+		MixLookup(A, B, C);
+		// Advance
+		Value += 12;
+		Length -= 12;
+	}
+
+	// The last block, nothing is mixed when there's no data left
+	if (Length > 0)
+	{
+		// Load it
+		uint32_t Block[3];
+		LoadPathTail(Value, Length, Block);
+		// Finalize it
+		A += Block[0]; B += Block[1]; C += Block[2];
+		FinalLookup(A, B, C);
+	}
+
+	// Return actual hash (C is primary, B is secondary)
+	return C + ((uint64_t)B << 32);
+}
+
+// Rotates each 32bit lane left
+#define RotateLanes(Value, Shift) _mm_or_si128(_mm_slli_epi32(Value, Shift), _mm_srli_epi32(Value, 32 - Shift))
+
+// The lookup3 mix, over lanes
+inline void MixLookupLanes(__m128i& A, __m128i& B, __m128i& C)
+{
+	A = _mm_sub_epi32(A, C); A = _mm_xor_si128(A, RotateLanes(C, 4)); C = _mm_add_epi32(C, B);
+	B = _mm_sub_epi32(B, A); B = _mm_xor_si128(B, RotateLanes(A, 6)); A = _mm_add_epi32(A, C);
+	C = _mm_sub_epi32(C, B); C = _mm_xor_si128(C, RotateLanes(B, 8)); B = _mm_add_epi32(B, A);
+	A = _mm_sub_epi32(A, C); A = _mm_xor_si128(A, RotateLanes(C, 16)); C = _mm_add_epi32(C, B);
+	B = _mm_sub_epi32(B, A); B = _mm_xor_si128(B, RotateLanes(A, 19)); A = _mm_add_epi32(A, C);
+	C = _mm_sub_epi32(C, B); C = _mm_xor_si128(C, RotateLanes(B, 4)); B = _mm_add_epi32(B, A);
+}
+
+// Normalizes a path into a 16 byte aligned buffer, zero-filled up to the next 12 and 16 byte boundaries
+void NormalizePath(const char* Value, size_t Length, uint8_t* Buffer)
+{
+	// The size we normalize, whole vectors covering a whole last block
+	auto Size = (Length + 12 + 15) & ~(size_t)15;
+
+	// Copy it
+	std::memcpy(Buffer, Value, Length);
+	std::memset(Buffer + Length, 0, Size - Length);
+
+	// The constants
+	auto BeforeA = _mm_set1_epi8('A' - 1);
+	auto AfterZ = _mm_set1_epi8('Z' + 1);
+	auto LowerBit = _mm_set1_epi8(0x20);
+	auto Slash = _mm_set1_epi8('/');
+	auto SlashSwap = _mm_set1_epi8('/' ^ '\\');
+
+	// Normalize it, bytes past 0x7F compare as negative so they are left alone
+	for (size_t i = 0; i < Size; i += 16)
+	{
+		// Load it
+		auto Data = _mm_load_si128((const __m128i*)(Buffer + i));
+		// Lowercase 'A'-'Z'
+		auto Upper = _mm_and_si128(_mm_cmpgt_epi8(Data, BeforeA), _mm_cmplt_epi8(Data, AfterZ));
+		Data = _mm_or_si128(Data, _mm_and_si128(Upper, LowerBit));
+		// Swap '/' for '\\'
+		Data = _mm_xor_si128(Data, _mm_and_si128(_mm_cmpeq_epi8(Data, Slash), SlashSwap));
+		// Store it
+		_mm_store_si128((__m128i*)(Buffer + i), Data);
+	}
+}
+
+// Hashes the remaining blocks of a normalized, zero-filled path, from the given state
+uint64_t FinishNormalizedLookup(const uint8_t* Value, size_t Length, uint32_t A, uint32_t B, uint32_t C)
+{
+	// The words
+	auto Words = (const uint32_t*)Value;
+
+	// All but the last block
+	while (Length > 12)
+	{
+		// Mix it
+		A += Words[0]; B += Words[1]; C += Words[2];
+		MixLookup(A, B, C);
+		// Advance
+		Words += 3;
+		Length -= 12;
+	}
+
+	// The last block, the zero fill matches lookup3's masking
+	if (Length > 0)
+	{
+		A += Words[0]; B += Words[1]; C += Words[2];
+		FinalLookup(A, B, C);
+	}
+
+	// Return actual hash (C is primary, B is secondary)
+	return C + ((uint64_t)B << 32);
+}
+
+uint64_t IFSPathHash::HashLookup(const char* Value, size_t Length)
+{
+	// Normalize short paths on the stack
+	if (Length <= IFS_PATH_HASH_STACK)
+	{
+		// The buffer, with room for the zero fill
+		__m128i Buffer[(IFS_PATH_HASH_STACK / 16) + 2];
+		// Normalize it
+		NormalizePath(Value, Length, (uint8_t*)Buffer);
+		// Hash it, the initial values are 2 (primary) and 1 (secondary)
+		auto Seed = 0xdeadbeef + (uint32_t)Length + 2;
+		return FinishNormalizedLookup((const uint8_t*)Buffer, Length, Seed, Seed, Seed + 1);
+	}
+
+	// Hash it, normalizing a word at a time
+	auto Seed = 0xdeadbeef + (uint32_t)Length + 2;
+	return FinishLookup(Value, Length, Seed, Seed, Seed + 1);
+}
+
+// Reads a 64bit value
+inline uint64_t ReadXXHash64(const char* Value)
+{
+	uint64_t Result;
+	std::memcpy(&Result, Value, sizeof(Result));
+	return Result;
+}
+
+// Reads a 32bit value
+inline uint32_t ReadXXHash32(const char* Value)
+{
+	uint32_t Result;
+	std::memcpy(&Result, Value, sizeof(Result));
+	return Result;
+}
+
+// The XXHash64 round
+inline uint64_t RoundXXHash64(uint64_t Accumulator, uint64_t Input)
+{
+	Accumulator += Input * IFS_XXH_PRIME2;
+	Accumulator = RotateLeft64(Accumulator, 31);
+	return Accumulator * IFS_XXH_PRIME1;
+}
+
+// The XXHash64 accumulator merge
+inline uint64_t MergeXXHash64(uint64_t Accumulator, uint64_t Value)
+{
+	Accumulator ^= RoundXXHash64(0, Value);
+	return Accumulator * IFS_XXH_PRIME1 + IFS_XXH_PRIME4;
+}
+
+uint64_t IFSPathHash::HashEntry(const char* Value, size_t Length)
+{
+	// The end of the value
+	auto End = Value + Length;
+	// The result
+	uint64_t Result;
+
+	// Long values use four accumulators
+	if (Length >= 32)
+	{
+		// Setup
+		uint64_t V1 = IFS_XXH_PRIME1 + IFS_XXH_PRIME2;
+		uint64_t V2 = IFS_XXH_PRIME2;
+		uint64_t V3 = 0;
+		uint64_t V4 = 0 - IFS_XXH_PRIME1;
+
+		// Consume each stripe
+		do
+		{
+			V1 = RoundXXHash64(V1, ReadXXHash64(Value));
+			V2 = RoundXXHash64(V2, ReadXXHash64(Value + 8));
+			V3 = RoundXXHash64(V3, ReadXXHash64(Value + 16));
+			V4 = RoundXXHash64(V4, ReadXXHash64(Value + 24));
+			Value += 32;
+		} while (Value <= End - 32);
+
+		// Merge them
+		Result = RotateLeft64(V1, 1) + RotateLeft64(V2, 7) + RotateLeft64(V3, 12) + RotateLeft64(V4, 18);
+		Result = MergeXXHash64(Result, V1);
+		Result = MergeXXHash64(Result, V2);
+		Result = MergeXXHash64(Result, V3);
+		Result = MergeXXHash64(Result, V4);
+	}
+	else
+	{
+		// Setup
+		Result = IFS_XXH_PRIME5;
+	}
+
+	// Add the length
+	Result += (uint64_t)Length;
+
+	// Consume the tail
+	while (Value + 8 <= End)
+	{
+		Result ^= RoundXXHash64(0, ReadXXHash64(Value));
+		Result = RotateLeft64(Result, 27) * IFS_XXH_PRIME1 + IFS_XXH_PRIME4;
+		Value += 8;
+	}
+	if (Value + 4 <= End)
+	{
+		Result ^= (uint64_t)ReadXXHash32(Value) * IFS_XXH_PRIME1;
+		Result = RotateLeft64(Result, 23) * IFS_XXH_PRIME2 + IFS_XXH_PRIME3;
+		Value += 4;
+	}
+	while (Value < End)
+	{
+		Result ^= (uint64_t)(uint8_t)*Value * IFS_XXH_PRIME5;
+		Result = RotateLeft64(Result, 11) * IFS_XXH_PRIME1;
+		Value++;
+	}
+
+	// Avalanche
+	Result ^= Result >> 33;
+	Result *= IFS_XXH_PRIME2;
+	Result ^= Result >> 29;
+	Result *= IFS_XXH_PRIME3;
+	Result ^= Result >> 32;
+
+	// Return it
+	return Result;
+}
+
+void IFSPathHash::HashLine(const IFSListFileLine& Line, uint64_t& EntryHash, uint64_t& LookupHash)
+{
+	// Hash the path, then the file name while it's still in cache
+	LookupHash = HashLookup(Line.Line, Line.LineLength);
+	EntryHash = HashEntry(Line.Name, Line.NameLength);
+}
+
+void IFSPathHash::HashLines(const IFSListFileLine* Lines, uint32_t Count, uint64_t* EntryHashes, uint64_t* LookupHashes)
+{
+	// The normalized lanes
+	__m128i Buffers[IFS_PATH_HASH_LANES][(IFS_PATH_HASH_STACK / 16) + 2];
+
+	// Hash in batches of lanes
+	while (Count >= IFS_PATH_HASH_LANES)
+	{
+		// Long paths are hashed on their own
+		if (Lines[0].LineLength > IFS_PATH_HASH_STACK || Lines[1].LineLength > IFS_PATH_HASH_STACK || Lines[2].LineLength > IFS_PATH_HASH_STACK || Lines[3].LineLength > IFS_PATH_HASH_STACK)
+		{
+			// Hash them
+			for (uint32_t i = 0; i < IFS_PATH_HASH_LANES; i++)
+				HashLine(Lines[i], EntryHashes[i], LookupHashes[i]);
+		}
+		else
+		{
+			// The count of blocks every lane mixes, the last block of each line is finalized on its own
+			size_t SharedBlocks = (size_t)-1;
+			// The initial state of each lane
+			uint32_t Seeds[IFS_PATH_HASH_LANES];
+
+			// Setup each lane
+			for (uint32_t i = 0; i < IFS_PATH_HASH_LANES; i++)
+			{
+				// Normalize it
+				NormalizePath(Lines[i].Line, Lines[i].LineLength, (uint8_t*)Buffers[i]);
+
+				// Mixed blocks are all but the last
+				auto Blocks = (Lines[i].LineLength > 0) ? (Lines[i].LineLength - 1) / 12 : 0;
+				// Keep the smallest
+				if (Blocks < SharedBlocks)
+					SharedBlocks = Blocks;
+
+				// The initial state
+				Seeds[i] = 0xdeadbeef + (uint32_t)Lines[i].LineLength + 2;
+			}
+
+			// Setup the state
+			auto A = _mm_loadu_si128((const __m128i*)Seeds);
+			auto B = A;
+			auto C = _mm_add_epi32(A, _mm_set1_epi32(1));
+
+			// Mix the shared blocks of every lane together
+			for (size_t Block = 0; Block < SharedBlocks; Block++)
+			{
+				// Load the block of each lane, the 4th word is ignored
+				auto Lane0 = _mm_loadu_si128((const __m128i*)((const uint8_t*)Buffers[0] + (Block * 12)));
+				auto Lane1 = _mm_loadu_si128((const __m128i*)((const uint8_t*)Buffers[1] + (Block * 12)));
+				auto Lane2 = _mm_loadu_si128((const __m128i*)((const uint8_t*)Buffers[2] + (Block * 12)));
+				auto Lane3 = _mm_loadu_si128((const __m128i*)((const uint8_t*)Buffers[3] + (Block * 12)));
+
+				// Transpose them, so each word lines up across the lanes
+				auto Low01 = _mm_unpacklo_epi32(Lane0, Lane1);
+				auto Low23 = _mm_unpacklo_epi32(Lane2, Lane3);
+				auto High01 = _mm_unpackhi_epi32(Lane0, Lane1);
+				auto High23 = _mm_unpackhi_epi32(Lane2, Lane3);
+
+				// Add them
+				A = _mm_add_epi32(A, _mm_unpacklo_epi64(Low01, Low23));
+				B = _mm_add_epi32(B, _mm_unpackhi_epi64(Low01, Low23));
+				C = _mm_add_epi32(C, _mm_unpacklo_epi64(High01, High23));
+
+				// Mix them
+				MixLookupLanes(A, B, C);
+			}
+
+			// Grab the state of each lane
+			uint32_t StateA[IFS_PATH_HASH_LANES], StateB[IFS_PATH_HASH_LANES], StateC[IFS_PATH_HASH_LANES];
+			_mm_storeu_si128((__m128i*)StateA, A);
+			_mm_storeu_si128((__m128i*)StateB, B);
+			_mm_storeu_si128((__m128i*)StateC, C);
+
+			// Finish each lane on its own
+			for (uint32_t i = 0; i < IFS_PATH_HASH_LANES; i++)
+			{
+				// Skip the shared blocks
+				auto Offset = SharedBlocks * 12;
+				// Finish it
+				LookupHashes[i] = FinishNormalizedLookup((const uint8_t*)Buffers[i] + Offset, Lines[i].LineLength - Offset, StateA[i], StateB[i], StateC[i]);
+				EntryHashes[i] = HashEntry(Lines[i].Name, Lines[i].NameLength);
+			}
+		}
+
+		// Advance
+		Lines += IFS_PATH_HASH_LANES;
+		EntryHashes += IFS_PATH_HASH_LANES;
+		LookupHashes += IFS_PATH_HASH_LANES;
+		Count -= IFS_PATH_HASH_LANES;
+	}
+
+	// Hash the rest on their own
+	for (uint32_t i = 0; i < Count; i++)
+		HashLine(Lines[i], EntryHashes[i], LookupHashes[i]);
+}
\ No newline at end of file
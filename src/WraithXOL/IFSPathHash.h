@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstdint>
+
+// We need the list file line
+#include "IFSListFileReader.h"
+
+// A class that hashes list file paths in one call, normalizing them as they are hashed instead of building copies
+class IFSPathHash
+{
+public:
+	// Calculates the JenkinsHashLittle2 of a path, lowercased with '/' replaced by '\\'
+	static uint64_t HashLookup(const char* Value, size_t Length);
+	// Calculates the XXHash64 of a value (Seed 0)
+	static uint64_t HashEntry(const char* Value, size_t Length);
+
+	// Calculates both hashes of a line, the entry hash is of the file name
+	static void HashLine(const IFSListFileLine& Line, uint64_t& EntryHash, uint64_t& LookupHash);
+	// Calculates both hashes of up to 4 lines at once, the lookup hashes share SSE2 lanes
+	static void HashLines(const IFSListFileLine* Lines, uint32_t Count, uint64_t* EntryHashes, uint64_t* LookupHashes);
+};
\ No newline at end of file
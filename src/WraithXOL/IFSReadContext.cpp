@@ -0,0 +1,148 @@
+#include "stdafx.h"
+
+// The class we are implementing
+#include "IFSReadContext.h"
+
+// We need zlib for the inflate stream
+#include "zlib.h"
+
+IFSReadContext::IFSReadContext()
+{
+	// Defaults
+	this->OutputCapacity = 0;
+	this->OutputSize = 0;
+	this->OutputPosition = 0;
+	this->DecryptSpanCapacity = 0;
+	this->InflateStream = nullptr;
+	this->InflaterBackend = IFSInflateBackend::ZLib;
+}
+
+IFSReadContext::~IFSReadContext()
+{
+	// Clean up the inflate stream
+	if (this->InflateStream != nullptr)
+	{
+		inflateEnd(this->InflateStream);
+		delete this->InflateStream;
+	}
+}
+
+const uint8_t* IFSReadContext::GetData() const
+{
+	return this->Output.get();
+}
+
+uint32_t IFSReadContext::GetDataSize() const
+{
+	return this->OutputSize;
+}
+
+bool IFSReadContext::Begin(uint32_t UnpackedSize)
+{
+	// Grow the buffer if needed, it's never shrunk
+	if (UnpackedSize > this->OutputCapacity || this->Output == nullptr)
+	{
+		this->Output = std::make_unique<uint8_t[]>(UnpackedSize);
+		this->OutputCapacity = UnpackedSize;
+	}
+
+	// Reset
+	this->OutputSize = UnpackedSize;
+	this->OutputPosition = 0;
+
+	// Success
+	return true;
+}
+
+bool IFSReadContext::Write(const uint8_t* Data, uint32_t Size)
+{
+	// Verify it fits
+	if (Size > (this->OutputSize - this->OutputPosition))
+		return false;
+
+	// Copy it
+	std::memcpy(this->Output.get() + this->OutputPosition, Data, Size);
+	// Advance
+	this->OutputPosition += Size;
+
+	// Success
+	return true;
+}
+
+uint8_t* IFSReadContext::GetDirectBuffer()
+{
+	return this->Output.get();
+}
+
+z_stream_s* IFSReadContext::ResetInflate()
+{
+	// Reuse the stream if we have one
+	if (this->InflateStream != nullptr)
+		return (inflateReset(this->InflateStream) == Z_OK) ? this->InflateStream : nullptr;
+
+	// Setup the inflate stream
+	auto Stream = new z_stream();
+	// Clear it
+	std::memset(Stream, 0, sizeof(z_stream));
+
+	// Initialize
+	if (inflateInit(Stream) != Z_OK)
+	{
+		// Failed
+		delete Stream;
+		return nullptr;
+	}
+
+	// Keep it
+	this->InflateStream = Stream;
+
+	// Return it
+	return this->InflateStream;
+}
+
+IFSInflater* IFSReadContext::GetInflater(IFSInflateBackend Backend)
+{
+	// Create it on first use, or if the backend changed
+	if (this->Inflater == nullptr || this->InflaterBackend != Backend)
+	{
+		this->Inflater = IFSInflater::Create(Backend);
+		this->InflaterBackend = Backend;
+	}
+
+	return this->Inflater.get();
+}
+
+uint8_t* IFSReadContext::GetDecryptBuffer()
+{
+	// Allocate on first use
+	if (this->DecryptBuffer == nullptr)
+		this->DecryptBuffer = std::make_unique<uint8_t[]>(0x8000);
+
+	return this->DecryptBuffer.get();
+}
+
+uint8_t* IFSReadContext::GetDecryptSpanBuffer(uint32_t Size)
+{
+	// Grow it if needed
+	if (Size > this->DecryptSpanCapacity)
+	{
+		this->DecryptSpanBuffer = std::make_unique<uint8_t[]>(Size);
+		this->DecryptSpanCapacity = Size;
+	}
+
+	return this->DecryptSpanBuffer.get();
+}
+
+uint8_t* IFSReadContext::GetOutputWindow()
+{
+	// Allocate on first use
+	if (this->OutputWindow == nullptr)
+		this->OutputWindow = std::make_unique<uint8_t[]>(0x10000);
+
+	return this->OutputWindow.get();
+}
+
+std::string& IFSReadContext::GetNameBuffer()
+{
+	return this->NameBuffer;
+}
\ No newline at end of file
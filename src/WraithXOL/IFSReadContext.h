@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+// We need the sink interface
+#include "IFSEntrySink.h"
+// We need the inflate backends
+#include "IFSInflater.h"
+
+// The zlib inflate stream
+struct z_stream_s;
+
+// Reusable buffers for reading entries, owned by the caller, one per thread, so steady-state reads don't allocate
+class IFSReadContext : public IFSEntrySink
+{
+public:
+	// Constructors
+	IFSReadContext();
+	virtual ~IFSReadContext();
+
+	// Gets the last decoded entry, valid until the next read with this context
+	const uint8_t* GetData() const;
+	// Gets the size of the last decoded entry
+	uint32_t GetDataSize() const;
+
+	// The output sink, the buffer only grows
+	virtual bool Begin(uint32_t UnpackedSize);
+	virtual bool Write(const uint8_t* Data, uint32_t Size);
+	virtual uint8_t* GetDirectBuffer();
+
+	// Gets an inflate stream ready for a new entry, it's created once then reset
+	z_stream_s* ResetInflate();
+	// Gets a whole buffer inflater for the backend, it's created once, and again only if the backend changes
+	IFSInflater* GetInflater(IFSInflateBackend Backend);
+	// Gets the decrypt scratch block (0x8000 bytes)
+	uint8_t* GetDecryptBuffer();
+	// Gets a decrypt scratch span of at least the given size, it only grows
+	uint8_t* GetDecryptSpanBuffer(uint32_t Size);
+	// Gets the inflate window (0x10000 bytes)
+	uint8_t* GetOutputWindow();
+	// Gets a scratch string for entry names, its capacity is reused
+	std::string& GetNameBuffer();
+
+private:
+	// The output buffer
+	std::unique_ptr<uint8_t[]> Output;
+	// The capacity of the output buffer
+	uint32_t OutputCapacity;
+	// The size of the last entry
+	uint32_t OutputSize;
+	// The current write position
+	uint32_t OutputPosition;
+
+	// The scratch buffers
+	std::unique_ptr<uint8_t[]> DecryptBuffer;
+	std::unique_ptr<uint8_t[]> OutputWindow;
+	// The scratch span, and its capacity
+	std::unique_ptr<uint8_t[]> DecryptSpanBuffer;
+	uint32_t DecryptSpanCapacity;
+	// The scratch name
+	std::string NameBuffer;
+
+	// The inflate stream, null until first used
+	z_stream_s* InflateStream;
+	// The whole buffer inflater, and its backend
+	std::unique_ptr<IFSInflater> Inflater;
+	IFSInflateBackend InflaterBackend;
+
+	// Prevent copies, we own the inflate stream
+	IFSReadContext(const IFSReadContext&);
+	IFSReadContext& operator=(const IFSReadContext&);
+};
\ No newline at end of file
@@ -0,0 +1,174 @@
+#include "stdafx.h"
+
+// The class we are implementing
+#include "IFSThreadPool.h"
+
+// We need the following std classes
+#include <algorithm>
+
+IFSThreadPool::IFSThreadPool(uint32_t WorkerCount)
+{
+	// Defaults
+	this->ShuttingDown = false;
+
+	// Use the hardware thread count if not specified, the caller thread counts as one
+	if (WorkerCount == 0)
+	{
+		// Fetch it
+		auto HardwareCount = std::thread::hardware_concurrency();
+		// Calculate
+		WorkerCount = (HardwareCount > 1) ? HardwareCount - 1 : 0;
+	}
+
+	// Spawn the workers
+	for (uint32_t i = 0; i < WorkerCount; i++)
+		this->Workers.emplace_back(&IFSThreadPool::WorkerMain, this);
+}
+
+IFSThreadPool::~IFSThreadPool()
+{
+	// Ask the workers to stop
+	{
+		std::lock_guard<std::mutex> Lock(this->JobsMutex);
+		// Set it
+		this->ShuttingDown = true;
+	}
+
+	// Wake them
+	this->JobsSignal.notify_all();
+
+	// Wait for them
+	for (auto& Worker : this->Workers)
+		Worker.join();
+}
+
+void IFSThreadPool::ParallelFor(size_t Count, const std::function<void(size_t)>& Task)
+{
+	// Run inline when there's nothing to split
+	if (Count <= 1 || this->Workers.size() == 0)
+	{
+		// Run them
+		for (size_t i = 0; i < Count; i++)
+			Task(i);
+
+		// Done
+		return;
+	}
+
+	// Setup the job
+	IFSThreadJob Job;
+	Job.Task = &Task;
+	Job.Count = Count;
+	Job.NextIndex = 0;
+	Job.ActiveWorkers = 0;
+
+	// Publish it
+	{
+		std::lock_guard<std::mutex> Lock(this->JobsMutex);
+		// Add it
+		this->Jobs.push_back(&Job);
+	}
+
+	// Wake the workers
+	this->JobsSignal.notify_all();
+
+	// Help out
+	RunJob(Job);
+
+	// Every index was taken, wait for the workers still on this job
+	std::unique_lock<std::mutex> Lock(this->JobsMutex);
+	// Wait
+	this->DoneSignal.wait(Lock, [&Job] { return (Job.ActiveWorkers == 0); });
+
+	// Remove the job, nobody can pick it up after this
+	this->Jobs.erase(std::find(this->Jobs.begin(), this->Jobs.end(), &Job));
+
+	// Pass on a failure, now that nothing refers to the job
+	if (Job.Failure != nullptr)
+		std::rethrow_exception(Job.Failure);
+}
+
+uint32_t IFSThreadPool::GetThreadCount() const
+{
+	return (uint32_t)this->Workers.size() + 1;
+}
+
+void IFSThreadPool::WorkerMain()
+{
+	// Lock the jobs
+	std::unique_lock<std::mutex> Lock(this->JobsMutex);
+
+	// Loop until asked to stop
+	while (true)
+	{
+		// Find a job with indices left
+		IFSThreadJob* Job = nullptr;
+		// Iterate
+		for (auto& Pending : this->Jobs)
+		{
+			// Check it
+			if (Pending->NextIndex < Pending->Count)
+			{
+				Job = Pending;
+				break;
+			}
+		}
+
+		// Wait for work if we found nothing
+		if (Job == nullptr)
+		{
+			// Check if we should stop
+			if (this->ShuttingDown)
+				return;
+
+			// Wait
+			this->JobsSignal.wait(Lock);
+			continue;
+		}
+
+		// Join the job
+		Job->ActiveWorkers++;
+
+		// Run it unlocked
+		Lock.unlock();
+		RunJob(*Job);
+		Lock.lock();
+
+		// Leave the job
+		if (--Job->ActiveWorkers == 0)
+			this->DoneSignal.notify_all();
+	}
+}
+
+void IFSThreadPool::RunJob(IFSThreadJob& Job)
+{
+	// Take indices until there are none left
+	while (true)
+	{
+		// Fetch the next index
+		auto Index = Job.NextIndex++;
+		// Check it
+		if (Index >= Job.Count)
+			break;
+
+		// Run it, nothing may escape a worker, or unwind past a queued job
+		try
+		{
+			(*Job.Task)(Index);
+		}
+		catch (...)
+		{
+			// Keep the first one, for the caller
+			{
+				std::lock_guard<std::mutex> Lock(this->JobsMutex);
+				// Set it
+				if (Job.Failure == nullptr)
+					Job.Failure = std::current_exception();
+			}
+
+			// Don't start any more indices
+			Job.NextIndex = Job.Count;
+			break;
+		}
+	}
+}
\ No newline at end of file
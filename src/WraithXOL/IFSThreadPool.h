@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstdint>
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <vector>
+#include <exception>
+
+// A class that runs indexed tasks across a set of worker threads
+class IFSThreadPool
+{
+public:
+	// Constructors (0 workers uses the hardware thread count)
+	IFSThreadPool(uint32_t WorkerCount = 0);
+	~IFSThreadPool();
+
+	// Runs the task for every index in [0, Count), the calling thread helps out, returns once all are complete (If a task throws, no new indices are started, and the first exception is rethrown here once the workers leave)
+	void ParallelFor(size_t Count, const std::function<void(size_t)>& Task);
+
+	// Gets the count of threads that work on a task, including the caller
+	uint32_t GetThreadCount() const;
+
+private:
+	// A set of indexed tasks being worked on
+	struct IFSThreadJob
+	{
+		// The task to run
+		const std::function<void(size_t)>* Task;
+		// The count of indices
+		size_t Count;
+		// The next index to run
+		std::atomic<size_t> NextIndex;
+		// The count of workers running this job (Guarded by JobsMutex)
+		uint32_t ActiveWorkers;
+		// The first exception thrown by the task (Guarded by JobsMutex)
+		std::exception_ptr Failure;
+	};
+
+	// The worker threads
+	std::vector<std::thread> Workers;
+
+	// The active jobs
+	std::deque<IFSThreadJob*> Jobs;
+	// Guards the jobs
+	std::mutex JobsMutex;
+	// Signaled when a job is added or we shut down
+	std::condition_variable JobsSignal;
+	// Signaled when a worker leaves a job
+	std::condition_variable DoneSignal;
+
+	// Whether or not we are shutting down
+	bool ShuttingDown;
+
+	// The worker thread routine
+	void WorkerMain();
+	// Runs indices of a job until none are left, or one throws
+	void RunJob(IFSThreadJob& Job);
+
+	// Prevent copies, we own the threads
+	IFSThreadPool(const IFSThreadPool&);
+	IFSThreadPool& operator=(const IFSThreadPool&);
+};
\ No newline at end of file
@@ -0,0 +1,441 @@
+#include "stdafx.h"
+
+// The class we are implementing
+#include "IFSUnpacker.h"
+
+// We need the following WraithX classes
+#include "Strings.h"
+#include "FileSystems.h"
+#include "BinaryWriter.h"
+#include "Image.h"
+#include "Console.h"
+#include "Hashing.h"
+
+// We need the cod helper classes
+#include "CoDIWITranslator.h"
+
+// We need the queues, and the content hash
+#include "IFSWorkQueue.h"
+#include "IFSPathHash.h"
+
+// We need the following std classes
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <algorithm>
+
+// The limits of the packed entries waiting to be decoded
+#define IFS_UNPACK_DECODE_COUNT 0x100
+#define IFS_UNPACK_DECODE_BYTES 0x4000000
+// The limits of the decoded images waiting to be converted
+#define IFS_UNPACK_CONVERT_COUNT 0x40
+#define IFS_UNPACK_CONVERT_BYTES 0x10000000
+// The limits of the results waiting to be written
+#define IFS_UNPACK_WRITE_COUNT 0x40
+#define IFS_UNPACK_WRITE_BYTES 0x8000000
+// The file listing the duplicate entries, and what they point to
+#define IFS_UNPACK_MANIFEST "duplicates.csv"
+
+// An entry moving through the stages
+struct IFSUnpackJob
+{
+	// The index in the list file
+	size_t Index;
+
+	// The packed data, in the mapped package, which stays mapped while the library is loaded, or in Data when it had to be copied
+	const uint8_t* PackedData;
+	// The copied packed, then decoded data
+	std::unique_ptr<uint8_t[]> Data;
+	// The size of the data
+	uint32_t DataSize;
+
+	// The converted image, when writing a dds
+	std::unique_ptr<XImageDDS> Image;
+
+	// The path to write to
+	std::string OutputPath;
+
+	IFSUnpackJob() : Index(0), PackedData(nullptr), DataSize(0) { }
+};
+
+// The first entry seen with some decoded data
+struct IFSUnpackContent
+{
+	// The size of the data, checked along with the hash
+	uint32_t DataSize;
+	// The index in the list file
+	size_t Index;
+
+	IFSUnpackContent(uint32_t Size, size_t EntryIndex) : DataSize(Size), Index(EntryIndex) { }
+};
+
+// Gets the path an entry is exported to
+std::string GetUnpackOutputPath(const std::string& ExportFolder, const std::string& Name, bool DDS)
+{
+	// Audio is written as is
+	if (Strings::EndsWith(Name, ".mp3"))
+		return FileSystems::CombinePath(ExportFolder, FileSystems::GetFileName(Name));
+
+	// Images are converted
+	return FileSystems::CombinePath(ExportFolder, FileSystems::GetFileNameWithoutExtension(Name) + (DDS ? ".dds" : ".png"));
+}
+
+// Links each duplicate to the file written for its data, and writes the manifest, returns the count linked
+size_t LinkUnpackDuplicates(const std::vector<std::string>& ListFile, std::vector<std::pair<size_t, size_t>>& Duplicates, const std::string& ExportFolder, bool DDS)
+{
+	// List them in list file order
+	std::sort(Duplicates.begin(), Duplicates.end());
+
+	// The manifest, every duplicate is listed, linked or not
+	std::string Manifest = "path,original,linked\n";
+	// The count linked
+	size_t LinkedCount = 0;
+
+	// Iterate
+	for (auto& Duplicate : Duplicates)
+	{
+		// Get both paths
+		auto LinkPath = GetUnpackOutputPath(ExportFolder, ListFile[Duplicate.first], DDS);
+		auto TargetPath = GetUnpackOutputPath(ExportFolder, ListFile[Duplicate.second], DDS);
+
+		// Only link to a file that was written, failing that, the manifest entry is all there is
+		auto Linked = false;
+		// Check it
+		if (FileSystems::FileExists(TargetPath))
+		{
+			// Replace anything from an earlier unpack
+			if (FileSystems::FileExists(LinkPath))
+				FileSystems::DeleteFile(LinkPath);
+
+			// Link it
+			Linked = (CreateHardLinkA(LinkPath.c_str(), TargetPath.c_str(), NULL) != 0);
+		}
+
+		// Count it
+		if (Linked)
+			LinkedCount++;
+
+		// Add it
+		Manifest += FileSystems::GetFileName(LinkPath) + "," + FileSystems::GetFileName(TargetPath) + (Linked ? ",1\n" : ",0\n");
+	}
+
+	// Whether or not the manifest was written
+	bool Written = false;
+
+	// Write the manifest, the writer throws if the file is in use, or can't be written
+	try
+	{
+		auto Writer = BinaryWriter();
+		// Create it
+		if (Writer.Create(FileSystems::CombinePath(ExportFolder, IFS_UNPACK_MANIFEST)))
+		{
+			Writer.Write((int8_t*)&Manifest[0], (uint32_t)Manifest.size());
+			Written = true;
+		}
+	}
+	catch (...)
+	{
+		// Failed, reported below
+		Written = false;
+	}
+
+	// Report it, the links are still made
+	if (!Written)
+		Console::WriteLineHeader("IFS", "Failed to write \"%s\"", IFS_UNPACK_MANIFEST);
+
+	// Done
+	return LinkedCount;
+}
+
+IFSUnpacker::IFSUnpacker(const IFSLib& Library, uint32_t WorkerCount) : Library(Library)
+{
+	// Use the hardware thread count if not specified
+	if (WorkerCount == 0)
+		WorkerCount = std::thread::hardware_concurrency();
+	// We need at least one of each
+	if (WorkerCount < 2)
+		WorkerCount = 2;
+
+	// Image conversion is the heavy stage, so it gets most of the workers
+	this->DecodeWorkers = (WorkerCount / 4 > 0) ? WorkerCount / 4 : 1;
+	this->ConvertWorkers = WorkerCount - this->DecodeWorkers;
+
+	// Defaults
+	this->Deduplicate = false;
+	this->DuplicateCount = 0;
+	this->AbsentCount = 0;
+}
+
+IFSUnpacker::~IFSUnpacker()
+{
+	// Default
+}
+
+size_t IFSUnpacker::Unpack(const std::vector<std::string>& Names, const std::string& ExportFolder, bool DDS)
+{
+	// The names to unpack, "hires/x.iwi" and "x.iwi" resolve to the same entry and output path, so only the first is kept
+	std::vector<std::string> ListFile;
+	// The entries already listed
+	std::unordered_set<uint64_t> ListedEntries;
+
+	// Reserve
+	ListFile.reserve(Names.size());
+	// Iterate
+	for (auto& Name : Names)
+	{
+		// Hash it the same way reads do
+		if (ListedEntries.insert(Hashing::HashXXHashString(FileSystems::GetFileName(Name))).second)
+			ListFile.emplace_back(Name);
+	}
+
+	// The queues between each stage
+	IFSWorkQueue<IFSUnpackJob> DecodeQueue(IFS_UNPACK_DECODE_COUNT, IFS_UNPACK_DECODE_BYTES);
+	IFSWorkQueue<IFSUnpackJob> ConvertQueue(IFS_UNPACK_CONVERT_COUNT, IFS_UNPACK_CONVERT_BYTES);
+	IFSWorkQueue<IFSUnpackJob> WriteQueue(IFS_UNPACK_WRITE_COUNT, IFS_UNPACK_WRITE_BYTES);
+
+	// The count of exported entries
+	std::atomic<size_t> ExportedCount(0);
+	// The console is shared by every stage
+	std::mutex LogMutex;
+
+	// The first entry with each decoded data, keyed by its hash, and the entries that repeat one (Index, Original)
+	std::unordered_map<uint64_t, IFSUnpackContent> Contents;
+	std::vector<std::pair<size_t, size_t>> Duplicates;
+	// Guards the contents and duplicates
+	std::mutex ContentMutex;
+
+	// Logs an exported entry
+	auto LogExported = [&ListFile, &ExportedCount, &LogMutex](size_t Index)
+	{
+		// Count it
+		ExportedCount++;
+
+		// Log it
+		std::lock_guard<std::mutex> Lock(LogMutex);
+		Console::WriteLineHeader("IFS", "Exported \"%s\"", FileSystems::GetFileNameWithoutExtension(ListFile[Index]).c_str());
+	};
+
+	// The decode stage, decrypts and inflates the packed entries
+	auto DecodeMain = [this, &ListFile, &ExportFolder, DDS, &DecodeQueue, &ConvertQueue, &WriteQueue, &Contents, &Duplicates, &ContentMutex]()
+	{
+		// Scratch buffers for this worker
+		IFSReadContext Context;
+
+		// Take each entry
+		while (auto Job = DecodeQueue.Pop())
+		{
+			// Decode it into a buffer
+			IFSBufferSink Sink;
+			// Decode it
+			if (!this->Library.DecodePackedEntry(ListFile[Job->Index], Job->PackedData, Job->DataSize, Sink, Context))
+				continue;
+
+			// Take the result, the packed data is released
+			Job->Data = Sink.TakeBuffer(Job->DataSize);
+			Job->PackedData = nullptr;
+
+			// Skip data we've already seen, it's linked once everything is written
+			if (this->Deduplicate)
+			{
+				// Hash it, before taking the lock
+				auto ContentHash = IFSPathHash::HashEntry((const char*)Job->Data.get(), Job->DataSize);
+
+				// Check it
+				std::lock_guard<std::mutex> Lock(ContentMutex);
+				// Add it, or find the first one
+				auto Content = Contents.emplace(ContentHash, IFSUnpackContent(Job->DataSize, Job->Index));
+
+				// A matching hash with a different size is exported as is
+				if (!Content.second && Content.first->second.DataSize == Job->DataSize)
+				{
+					// Remember it
+					Duplicates.emplace_back(Job->Index, Content.first->second.Index);
+					continue;
+				}
+			}
+
+			// Audio doesn't need converting, it's written as is
+			if (Strings::EndsWith(ListFile[Job->Index], ".mp3"))
+			{
+				// Setup the path
+				Job->OutputPath = GetUnpackOutputPath(ExportFolder, ListFile[Job->Index], DDS);
+
+				// Queue it
+				auto JobSize = Job->DataSize;
+				WriteQueue.Push(std::move(Job), JobSize);
+			}
+			else
+			{
+				// Queue it
+				auto JobSize = Job->DataSize;
+				ConvertQueue.Push(std::move(Job), JobSize);
+			}
+		}
+	};
+
+	// The convert stage, translates images, and transcodes them
+	auto ConvertMain = [&ListFile, &ExportFolder, DDS, &ConvertQueue, &WriteQueue, &LogExported]()
+	{
+		// Each thread must setup the image converter
+		Image::SetupConversionThread();
+
+		// Take each image
+		while (auto Job = ConvertQueue.Pop())
+		{
+			// Convert IWI
+			auto IWIConv = CoDIWITranslator::TranslateIWI(Job->Data, Job->DataSize);
+
+			// Release the source
+			Job->Data.reset();
+			Job->DataSize = 0;
+
+			// Check
+			if (IWIConv == nullptr)
+				continue;
+
+			// Save to a file
+			if (DDS)
+			{
+				// Setup the path
+				Job->OutputPath = GetUnpackOutputPath(ExportFolder, ListFile[Job->Index], DDS);
+				// Hand over the image
+				auto JobSize = IWIConv->DataSize;
+				Job->Image = std::move(IWIConv);
+
+				// Queue it
+				WriteQueue.Push(std::move(Job), JobSize);
+			}
+			else
+			{
+				// Whether or not it was converted
+				bool Converted = false;
+
+				// Transcode to PNG, the converter throws if the file is in use, or can't be written
+				try
+				{
+					Image::ConvertImageMemory(IWIConv->DataBuffer, IWIConv->DataSize, ImageFormat::DDS_WithHeader, GetUnpackOutputPath(ExportFolder, ListFile[Job->Index], DDS), ImageFormat::Standard_PNG);
+					Converted = true;
+				}
+				catch (...)
+				{
+					// Nothing, already in access
+				}
+
+				// Log it
+				if (Converted)
+					LogExported(Job->Index);
+			}
+		}
+	};
+
+	// The write stage, writes the results to disk
+	auto WriteMain = [&WriteQueue, &LogExported]()
+	{
+		// Take each result
+		while (auto Job = WriteQueue.Pop())
+		{
+			// Whether or not it was written
+			bool Written = false;
+
+			// Write it, the writer throws if the file is in use, or can't be written
+			try
+			{
+				auto Writer = BinaryWriter();
+				// Create it
+				if (Writer.Create(Job->OutputPath))
+				{
+					// Write the image, or the raw data
+					if (Job->Image != nullptr)
+						Writer.Write(Job->Image->DataBuffer, Job->Image->DataSize);
+					else if (Job->DataSize > 0)
+						Writer.Write((int8_t*)Job->Data.get(), Job->DataSize);
+
+					// Done
+					Written = true;
+				}
+			}
+			catch (...)
+			{
+				// Nothing, already in access
+			}
+
+			// Log it
+			if (Written)
+				LogExported(Job->Index);
+		}
+	};
+
+	// Start the stages
+	std::vector<std::thread> Decoders;
+	std::vector<std::thread> Converters;
+
+	// Spawn them
+	for (uint32_t i = 0; i < this->DecodeWorkers; i++)
+		Decoders.emplace_back(DecodeMain);
+	for (uint32_t i = 0; i < this->ConvertWorkers; i++)
+		Converters.emplace_back(ConvertMain);
+
+	// Spawn the writer
+	std::thread Writer(WriteMain);
+
+	// The read stage runs here, in package order, blocking while the decoders are behind, entries that aren't downloaded yet are skipped (Mapped entries are decoded in place)
+	this->AbsentCount = this->Library.ReadPackedEntries(ListFile, [&DecodeQueue](size_t Index, const uint8_t* Data, uint64_t DataSize, bool Mapped)
+	{
+		// Setup the job
+		auto Job = std::make_unique<IFSUnpackJob>();
+		// Assign
+		Job->Index = Index;
+		Job->DataSize = (uint32_t)DataSize;
+		Job->PackedData = Data;
+
+		// Copy the data if it isn't mapped, the read is only valid during this call
+		if (!Mapped)
+		{
+			Job->Data = std::make_unique<uint8_t[]>((size_t)DataSize);
+			std::memcpy(Job->Data.get(), Data, (size_t)DataSize);
+			// Point to the copy
+			Job->PackedData = Job->Data.get();
+		}
+
+		// Queue it
+		DecodeQueue.Push(std::move(Job), DataSize);
+	});
+
+	// Drain each stage in order
+	DecodeQueue.Close();
+	for (auto& Decoder : Decoders)
+		Decoder.join();
+
+	ConvertQueue.Close();
+	for (auto& Converter : Converters)
+		Converter.join();
+
+	WriteQueue.Close();
+	Writer.join();
+
+	// Link the duplicates, now that the files they point to are written
+	this->DuplicateCount = Duplicates.size();
+	// Link them
+	if (!Duplicates.empty())
+		ExportedCount += LinkUnpackDuplicates(ListFile, Duplicates, ExportFolder, DDS);
+
+	// Return the count
+	return ExportedCount;
+}
+
+void IFSUnpacker::SetDeduplicate(bool Deduplicate)
+{
+	this->Deduplicate = Deduplicate;
+}
+
+size_t IFSUnpacker::GetDuplicateCount() const
+{
+	return this->DuplicateCount;
+}
+
+size_t IFSUnpacker::GetAbsentCount() const
+{
+	return this->AbsentCount;
+}
\ No newline at end of file
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// We need the IFS library
+#include "IFSLib.h"
+
+// A class that unpacks a whole list of entries through a pipeline of stages (read -> decode -> convert -> write), joined by bounded queues
+class IFSUnpacker
+{
+public:
+	// Constructors (0 workers uses the hardware thread count, split between the decode and convert stages)
+	IFSUnpacker(const IFSLib& Library, uint32_t WorkerCount = 0);
+	~IFSUnpacker();
+
+	// Unpacks the entries to the folder, images are converted to png, or dds if requested, returns the count exported (Names of the same entry are unpacked once)
+	size_t Unpack(const std::vector<std::string>& Names, const std::string& ExportFolder, bool DDS);
+
+	// Sets whether entries with the same decoded data are only written once, the rest are hardlinked to it, and listed in a manifest (Off by default)
+	void SetDeduplicate(bool Deduplicate);
+	// Gets the count of entries the last unpack found to be duplicates
+	size_t GetDuplicateCount() const;
+	// Gets the count of entries the last unpack skipped, as they aren't downloaded yet
+	size_t GetAbsentCount() const;
+
+private:
+	// The library we read from
+	const IFSLib& Library;
+
+	// The count of decode workers
+	uint32_t DecodeWorkers;
+	// The count of conversion workers
+	uint32_t ConvertWorkers;
+
+	// Whether or not duplicate entries are linked instead of written
+	bool Deduplicate;
+	// The count of duplicates found by the last unpack
+	size_t DuplicateCount;
+	// The count of entries the last unpack skipped
+	size_t AbsentCount;
+
+	// Prevent copies
+	IFSUnpacker(const IFSUnpacker&);
+	IFSUnpacker& operator=(const IFSUnpacker&);
+};
\ No newline at end of file
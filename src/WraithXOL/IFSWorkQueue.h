@@ -0,0 +1,103 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+
+// A bounded queue of work items passed between pipeline stages, producers block while it's full so memory stays bounded
+template<typename T>
+class IFSWorkQueue
+{
+public:
+	// Constructors (The queue is full past either limit, a single item is always accepted)
+	IFSWorkQueue(size_t MaxCount, uint64_t MaxBytes)
+	{
+		// Assign
+		this->MaxCount = MaxCount;
+		this->MaxBytes = MaxBytes;
+		this->QueuedBytes = 0;
+		this->Closed = false;
+	}
+
+	// Adds an item, blocking until there's room
+	void Push(std::unique_ptr<T> Item, uint64_t Bytes)
+	{
+		std::unique_lock<std::mutex> Lock(this->QueueMutex);
+		// Wait for room
+		this->PopSignal.wait(Lock, [this, Bytes] { return this->Items.empty() || (this->Items.size() < this->MaxCount && this->QueuedBytes + Bytes <= this->MaxBytes); });
+
+		// Add it
+		this->Items.push_back(std::move(Item));
+		this->ItemBytes.push_back(Bytes);
+		this->QueuedBytes += Bytes;
+
+		// Wake a consumer
+		Lock.unlock();
+		this->PushSignal.notify_one();
+	}
+
+	// Takes the next item, blocking until one is ready, returns null once the queue is closed and empty
+	std::unique_ptr<T> Pop()
+	{
+		std::unique_lock<std::mutex> Lock(this->QueueMutex);
+		// Wait for an item
+		this->PushSignal.wait(Lock, [this] { return !this->Items.empty() || this->Closed; });
+
+		// Check if we're done
+		if (this->Items.empty())
+			return nullptr;
+
+		// Take it
+		auto Result = std::move(this->Items.front());
+		this->QueuedBytes -= this->ItemBytes.front();
+		this->Items.pop_front();
+		this->ItemBytes.pop_front();
+
+		// Wake a producer
+		Lock.unlock();
+		this->PopSignal.notify_one();
+
+		// Return it
+		return Result;
+	}
+
+	// Stops accepting items, consumers drain what's left
+	void Close()
+	{
+		{
+			std::lock_guard<std::mutex> Lock(this->QueueMutex);
+			// Set it
+			this->Closed = true;
+		}
+
+		// Wake every consumer
+		this->PushSignal.notify_all();
+	}
+
+private:
+	// The queued items, and their sizes
+	std::deque<std::unique_ptr<T>> Items;
+	std::deque<uint64_t> ItemBytes;
+
+	// The limits
+	size_t MaxCount;
+	uint64_t MaxBytes;
+	// The size of the queued items
+	uint64_t QueuedBytes;
+
+	// Whether or not we've been closed
+	bool Closed;
+
+	// Guards the queue
+	std::mutex QueueMutex;
+	// Signaled when an item is added, or we close
+	std::condition_variable PushSignal;
+	// Signaled when an item is taken
+	std::condition_variable PopSignal;
+
+	// Prevent copies, we own the items
+	IFSWorkQueue(const IFSWorkQueue&);
+	IFSWorkQueue& operator=(const IFSWorkQueue&);
+};
\ No newline at end of file
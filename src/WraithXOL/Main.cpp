@@ -12,13 +12,15 @@
 #include "Instance.h"
 #include "FileSystems.h"
 #include "IFSLib.h"
+#include "IFSUnpacker.h"
+#include "IFSCatalog.h"
 #include "Systems.h"
 
 // We need the online game module
 #include "GameOnline.h"
 
 // Allows straight unpacking of IFS
-void UnpackIFSFile(const std::string& IFS, bool DDS = false)
+void UnpackIFSFile(const std::string& IFS, bool DDS = false, uint32_t WorkerCount = 0)
 {
 	// Make it
 	auto ExportFolder = FileSystems::CombinePath(FileSystems::CombinePath(FileSystems::GetApplicationPath(), "exported_files\\codol"), FileSystems::GetFileNameWithoutExtension(IFS));
@@ -26,7 +28,7 @@ void UnpackIFSFile(const std::string& IFS, bool DDS = false)
 	FileSystems::CreateDirectory(ExportFolder);
 
 	// Mount the IFS file
-	auto IFSHandler = IFSLib();
+	IFSLib IFSHandler;
 	// Load it
 	auto ListFile = IFSHandler.ParsePackage(IFS);
 
@@ -34,58 +36,201 @@ void UnpackIFSFile(const std::string& IFS, bool DDS = false)
 	Console::WriteLineHeader("IFS", "Loaded \"%s\"", FileSystems::GetFileName(IFS).c_str());
 	Console::WriteLineHeader("IFS", "Loaded %d files", ListFile.size());
 
-	// Iterate and export them
-	for (auto& File : ListFile)
+	// Unpack everything, entries are read in package order while the workers decode, convert and write them
+	IFSUnpacker Unpacker(IFSHandler, WorkerCount);
+	// Run it
+	auto ExportedCount = Unpacker.Unpack(ListFile, ExportFolder, DDS);
+
+	// Log complete
+	Console::WriteLineHeader("IFS", "Exported %d of %d files", ExportedCount, ListFile.size());
+	// Log what isn't downloaded yet
+	if (Unpacker.GetAbsentCount() > 0)
+		Console::WriteLineHeader("IFS", "Skipped %d files that aren't downloaded yet", Unpacker.GetAbsentCount());
+	Console::WriteLineHeader("IFS", "Exported all existing IFS assets");
+}
+
+// Unpacks every IFS file in a folder, loaded like the game does, hires first, entries with the same data are only written once
+void UnpackIFSPath(const std::string& IFSPath, bool DDS = false, uint32_t WorkerCount = 0)
+{
+	// Make it
+	auto ExportFolder = FileSystems::CombinePath(FileSystems::CombinePath(FileSystems::GetApplicationPath(), "exported_files\\codol"), FileSystems::GetFileName(IFSPath));
+	// Create it
+	FileSystems::CreateDirectory(ExportFolder);
+
+	// Mount the folder, with audio, like a single package
+	IFSLib IFSHandler;
+	// Load it
+	IFSHandler.MountIFSPath(IFSPath, "", true);
+
+	// List the loaded entries, each name once, from the package it was loaded from
+	IFSCatalog Catalog;
+	// Build it
+	IFSHandler.BuildCatalog(Catalog);
+
+	// Grab the names
+	std::vector<std::string> ListFile;
+	// Reserve
+	ListFile.reserve(Catalog.GetCount());
+	// Add them
+	for (size_t i = 0; i < Catalog.GetCount(); i++)
+		ListFile.emplace_back(Catalog.GetName(i));
+
+	// Log info
+	Console::WriteLineHeader("IFS", "Loaded \"%s\"", FileSystems::GetFileName(IFSPath).c_str());
+	Console::WriteLineHeader("IFS", "Loaded %d files", ListFile.size());
+
+	// Unpack everything, duplicates are linked to the first copy
+	IFSUnpacker Unpacker(IFSHandler, WorkerCount);
+	// Only write unique data
+	Unpacker.SetDeduplicate(true);
+	// Run it
+	auto ExportedCount = Unpacker.Unpack(ListFile, ExportFolder, DDS);
+
+	// Log complete
+	Console::WriteLineHeader("IFS", "Exported %d of %d files, %d were duplicates", ExportedCount, ListFile.size(), Unpacker.GetDuplicateCount());
+	// Log what isn't downloaded yet
+	if (Unpacker.GetAbsentCount() > 0)
+		Console::WriteLineHeader("IFS", "Skipped %d files that aren't downloaded yet", Unpacker.GetAbsentCount());
+	Console::WriteLineHeader("IFS", "Exported all existing IFS assets");
+}
+
+// Checks an IFS file against its MD5 table
+void VerifyIFSFile(const std::string& IFS)
+{
+	// Load the library, for the workers
+	IFSLib IFSHandler;
+
+	// Check it
+	IFSVerifyResult Result;
+	// Verify
+	if (!IFSHandler.VerifyPackage(IFS, Result))
 	{
-		// Fetch result file
-		auto FileName = FileSystems::GetFileName(File);
+		// Log it
+		Console::WriteLineHeader("IFS", "\"%s\" has no MD5 table to check", FileSystems::GetFileName(IFS).c_str());
+		return;
+	}
 
-		// Extract it
-		uint32_t ResultSize = 0;
-		// Read the entry
-		auto ResultFile = IFSHandler.ReadFileEntry(FileName, ResultSize);
+	// Log each bad range
+	for (auto& Range : Result.BadRanges)
+		Console::WriteLineHeader("IFS", "Bad range 0x%llx - 0x%llx", Range.Offset, Range.Offset + Range.Size);
 
-		// If not blank, export
-		if (ResultFile != nullptr)
-		{
-			// If MP3, write it, else, convert it
-			if (Strings::EndsWith(FileName, ".mp3"))
-			{
-				// Write to a file
-				auto Writer = BinaryWriter();
-				Writer.Create(FileSystems::CombinePath(ExportFolder, FileName));
-				Writer.Write(ResultFile.get(), ResultSize);
-			}
-			else
-			{
-				// Convert IWI
-				auto IWIConv = CoDIWITranslator::TranslateIWI(ResultFile, ResultSize);
-				// Check
-				if (IWIConv != nullptr)
-				{
-					// Save to a file
-					if (DDS)
-					{
-						// Write to a file, with a dds
-						auto Writer = BinaryWriter();
-						Writer.Create(FileSystems::CombinePath(ExportFolder, FileSystems::GetFileNameWithoutExtension(FileName) + ".dds"));
-						Writer.Write(IWIConv->DataBuffer, IWIConv->DataSize);
-					}
-					else
-					{
-						// Transcode to PNG
-						Image::ConvertImageMemory(IWIConv->DataBuffer, IWIConv->DataSize, ImageFormat::DDS_WithHeader, FileSystems::CombinePath(ExportFolder, FileSystems::GetFileNameWithoutExtension(FileName) + ".png"), ImageFormat::Standard_PNG);
-					}
-				}
-			}
+	// Log results
+	Console::WriteLineHeader("IFS", "Checked %llu pieces of \"%s\", %llu bad (%.1f MB/s)", Result.PiecesChecked, FileSystems::GetFileName(IFS).c_str(), Result.PiecesFailed, Result.GetThroughput());
+}
+
+// Lists the loaded entries matching a query, writing them out as "csv" or "json" if a format is given
+void CatalogIFS(const IFSLib& IFSHandler, IFSCatalogQuery QueryType, const std::string& Pattern, const std::string& Format, const std::string& ExportName)
+{
+	// Build the catalog, from the package tables only
+	IFSCatalog Catalog;
+	// Build it
+	IFSHandler.BuildCatalog(Catalog);
+
+	// Run the query, an empty prefix matches everything
+	std::vector<size_t> Results;
+	// Check it
+	if (!Catalog.Query(QueryType, Pattern, Results))
+	{
+		// Log it
+		Console::WriteLineHeader("IFS", "Invalid pattern \"%s\"", Pattern.c_str());
+		return;
+	}
+
+	// Sum the sizes
+	uint64_t CompressedSize = 0, FileSize = 0;
+	// Sum
+	Catalog.GetTotals(Results, CompressedSize, FileSize);
+
+	// Log results
+	Console::WriteLineHeader("IFS", "Matched %d of %d entries, %llu MB packed, %llu MB unpacked", Results.size(), Catalog.GetCount(), CompressedSize / (1024 * 1024), FileSize / (1024 * 1024));
+	// Log what isn't downloaded yet
+	if (Catalog.GetAbsentCount() > 0)
+		Console::WriteLineHeader("IFS", "Left out %llu entries that aren't downloaded yet, %llu MB packed", Catalog.GetAbsentCount(), Catalog.GetAbsentSize() / (1024 * 1024));
+
+	// Only export if asked
+	if (Format != "csv" && Format != "json")
+		return;
+
+	// Make the folder
+	auto ExportFolder = FileSystems::CombinePath(FileSystems::GetApplicationPath(), "exported_files\\codol");
+	// Create it
+	FileSystems::CreateDirectory(ExportFolder);
+
+	// Write it
+	auto ExportPath = FileSystems::CombinePath(ExportFolder, ExportName + "_catalog." + Format);
+	auto Success = (Format == "csv") ? Catalog.ExportCSV(ExportPath, Results) : Catalog.ExportJSON(ExportPath, Results);
+
+	// Log it
+	if (Success)
+		Console::WriteLineHeader("IFS", "Wrote \"%s\"", FileSystems::GetFileName(ExportPath).c_str());
+	else
+		Console::WriteLineHeader("IFS", "Failed to write \"%s\"", FileSystems::GetFileName(ExportPath).c_str());
+}
 
+// Times reading the image and sound entries with each inflate backend that was built
+void BenchmarkIFS(IFSLib& IFSHandler)
+{
+	// Build the catalog, to find the entries
+	IFSCatalog Catalog;
+	// Build it
+	IFSHandler.BuildCatalog(Catalog);
+
+	// Images and sounds make up most of the data
+	std::vector<size_t> Results;
+	Catalog.Query(IFSCatalogQuery::Regex, "\\.(iwi|mp3)$", Results);
+
+	// Grab the names once
+	std::vector<std::string> Names;
+	// Reserve
+	Names.reserve(Results.size());
+	// Iterate
+	for (auto& Result : Results)
+		Names.emplace_back(Catalog.GetName(Result));
+
+	// Remember the backend, to put it back
+	auto DefaultBackend = IFSHandler.GetInflateBackend();
+
+	// Run each backend
+	for (auto Backend : { IFSInflateBackend::ZLib, IFSInflateBackend::ZLibNG, IFSInflateBackend::LibDeflate })
+	{
+		// Skip the ones that weren't built
+		if (!IFSHandler.SetInflateBackend(Backend))
+		{
 			// Log it
-			Console::WriteLineHeader("IFS", "Exported \"%s\"", FileSystems::GetFileNameWithoutExtension(FileName).c_str());
+			Console::WriteLineHeader("Benchmark", "%s wasn't built", IFSInflater::GetName(Backend));
+			continue;
+		}
+
+		// A fresh context, so every backend starts cold
+		IFSReadContext Context;
+		// The totals
+		uint64_t UnpackedSize = 0;
+		uint32_t ReadCount = 0;
+
+		// Start the timer
+		auto Start = std::chrono::high_resolution_clock::now();
+
+		// Read each entry
+		for (auto& Name : Names)
+		{
+			// Read it
+			if (!IFSHandler.ReadFileEntry(Name, Context))
+				continue;
+
+			// Count it
+			UnpackedSize += Context.GetDataSize();
+			ReadCount++;
 		}
+
+		// Stop the timer
+		auto Seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - Start).count();
+
+		// Log results
+		Console::WriteLineHeader("Benchmark", "%s read %d of %d entries, %llu MB in %.2fs (%.1f MB/s)", IFSInflater::GetName(Backend), ReadCount, Names.size(), UnpackedSize / (1024 * 1024), Seconds, (Seconds > 0) ? ((double)UnpackedSize / (1024 * 1024)) / Seconds : 0.0);
 	}
 
-	// Log complete
-	Console::WriteLineHeader("IFS", "Exported all existing IFS assets");
+	// Put it back
+	IFSHandler.SetInflateBackend(DefaultBackend);
 }
 
 // Main entry point of app
@@ -118,20 +263,88 @@ int main(int argc, char** argv)
 		Console::WriteLineHeader("Initialize", "Desc: Allows extraction of models, animations, images and sounds");
 		Console::WriteLineHeader("Initialize", "-----------------------------------------------------------------");
 
-		// If we have an argument, and the argument is an IFS file, jump to the generic unpacker
-		if (argc > 1 && Strings::EndsWith(argv[1], ".ifs"))
+		// If we have an argument, and the argument is an IFS file, or a folder of them, jump to the generic unpacker
+		if (argc > 1 && (Strings::EndsWith(argv[1], ".ifs") || FileSystems::DirectoryExists(argv[1])))
 		{
-			// DDS flags
-			if (argc > 2 && Strings::StartsWith(argv[2], "dds"))
+			// Whether or not we were given a folder
+			auto IsFolder = !Strings::EndsWith(argv[1], ".ifs");
+
+			// The unpack options, in any order, "dds", "workers=<count>", "verify" (Only checks the package), "catalog" (Only lists the entries) and "bench" (Only times the inflate backends)
+			bool DDS = false;
+			bool Verify = false;
+			bool Catalog = false;
+			bool Benchmark = false;
+			uint32_t WorkerCount = 0;
+
+			// The catalog options, "prefix=<text>", "glob=<pattern>" or "regex=<pattern>", and "csv" or "json" to write it out
+			auto QueryType = IFSCatalogQuery::Prefix;
+			std::string Pattern = "";
+			std::string Format = "";
+
+			// Parse them
+			for (int i = 2; i < argc; i++)
+			{
+				// Fetch the option
+				auto Option = Strings::ToLower(argv[i]);
+
+				// Check
+				if (Strings::StartsWith(Option, "dds"))
+					DDS = true;
+				else if (Strings::StartsWith(Option, "workers="))
+					WorkerCount = (uint32_t)strtoul(Option.c_str() + 8, nullptr, 10);
+				else if (Option == "verify")
+					Verify = true;
+				else if (Option == "catalog")
+					Catalog = true;
+				else if (Option == "bench")
+					Benchmark = true;
+				else if (Option == "csv" || Option == "json")
+					Format = Option;
+				else if (Strings::StartsWith(Option, "prefix="))
+					Pattern = std::string(argv[i] + 7);
+				else if (Strings::StartsWith(Option, "glob="))
+				{
+					// Keep the pattern as given
+					QueryType = IFSCatalogQuery::Glob;
+					Pattern = std::string(argv[i] + 5);
+				}
+				else if (Strings::StartsWith(Option, "regex="))
+				{
+					// Keep the pattern as given, character classes are case sensitive
+					QueryType = IFSCatalogQuery::Regex;
+					Pattern = std::string(argv[i] + 6);
+				}
+			}
+
+			// Ask to check, list, or unpack this
+			if (Verify && IsFolder)
 			{
-				// Ask to unpack this
-				UnpackIFSFile(std::string(argv[1]), true);
+				// Check each package
+				for (auto& IFS : FileSystems::GetFiles(argv[1], "*.ifs"))
+					VerifyIFSFile(IFS);
 			}
-			else
+			else if (Verify)
+				VerifyIFSFile(std::string(argv[1]));
+			else if (Catalog || Benchmark)
 			{
-				// Ask to unpack this
-				UnpackIFSFile(std::string(argv[1]));
+				// Load the package, with audio, like the unpacker, or the whole folder
+				IFSLib IFSHandler;
+				// Load it
+				if (IsFolder)
+					IFSHandler.MountIFSPath(argv[1], "", true);
+				else
+					IFSHandler.ParsePackage(std::string(argv[1]));
+
+				// List it, or time it
+				if (Catalog)
+					CatalogIFS(IFSHandler, QueryType, Pattern, Format, FileSystems::GetFileNameWithoutExtension(argv[1]));
+				else
+					BenchmarkIFS(IFSHandler);
 			}
+			else if (IsFolder)
+				UnpackIFSPath(std::string(argv[1]), DDS, WorkerCount);
+			else
+				UnpackIFSFile(std::string(argv[1]), DDS, WorkerCount);
 
 			// End the routine
 			return 0;
@@ -232,8 +445,16 @@ int main(int argc, char** argv)
 					}
 
 					// Rip, then log
+					auto AbsentReads = GameOnline::IFSLibrary->GetAbsentReads();
 					GameOnline::ExtractAssets(false, true, false, false);
 					Console::WriteLineHeader("Exporter", "Exported all loaded XModels");
+
+					// Log how many images were reused
+					auto CacheStats = GameOnline::IFSLibrary->GetCacheStatistics();
+					Console::WriteLineHeader("IFS", "Image cache: %llu hits, %llu misses, %llu MB held", CacheStats.Hits, CacheStats.Misses, CacheStats.CachedBytes / (1024 * 1024));
+					// Log the images that aren't downloaded yet
+					if (GameOnline::IFSLibrary->GetAbsentReads() > AbsentReads)
+						Console::WriteLineHeader("IFS", "Skipped %llu images that aren't downloaded yet", GameOnline::IFSLibrary->GetAbsentReads() - AbsentReads);
 				}
 				else if (SplitCommand[0] == "ripimages")
 				{
@@ -253,8 +474,13 @@ int main(int argc, char** argv)
 					}
 
 					// Rip, then log
+					auto AbsentReads = GameOnline::IFSLibrary->GetAbsentReads();
 					GameOnline::ExtractAssets(false, false, true, false);
 					Console::WriteLineHeader("Exporter", "Exported all loaded XImages");
+
+					// Log the images that aren't downloaded yet
+					if (GameOnline::IFSLibrary->GetAbsentReads() > AbsentReads)
+						Console::WriteLineHeader("IFS", "Skipped %llu images that aren't downloaded yet", GameOnline::IFSLibrary->GetAbsentReads() - AbsentReads);
 				}
 				else if (SplitCommand[0] == "ripsounds")
 				{
@@ -262,10 +488,41 @@ int main(int argc, char** argv)
 					GameOnline::ExtractAssets(false, false, false, true);
 					Console::WriteLineHeader("Exporter", "Exported all loaded Sounds");
 				}
+				else if (SplitCommand[0] == "catalog")
+				{
+					// List the mounted entries, param 2 is the query type, param 3 the pattern, and param 4 the format (Default: prefix, everything, no file)
+					auto QueryType = IFSCatalogQuery::Prefix;
+					// Check the type
+					if (SplitCommand.size() > 1 && SplitCommand[1] == "glob")
+						QueryType = IFSCatalogQuery::Glob;
+					else if (SplitCommand.size() > 1 && SplitCommand[1] == "regex")
+						QueryType = IFSCatalogQuery::Regex;
+					else if (SplitCommand.size() > 1 && SplitCommand[1] != "prefix")
+					{
+						// Error
+						Console::WriteLineHeader("Command", "Unknown query, valid: \"prefix, glob, regex\" (Default: prefix)");
+
+						// Next
+						continue;
+					}
+
+					// Check the format
+					if (SplitCommand.size() > 3 && SplitCommand[3] != "csv" && SplitCommand[3] != "json")
+					{
+						// Error
+						Console::WriteLineHeader("Command", "Unknown format, valid: \"csv, json\"");
+
+						// Next
+						continue;
+					}
+
+					// List them
+					CatalogIFS(*GameOnline::IFSLibrary, QueryType, (SplitCommand.size() > 2) ? SplitCommand[2] : "", (SplitCommand.size() > 3) ? SplitCommand[3] : "", "mounted");
+				}
 				else
 				{
 					// Unknown command
-					Console::WriteLineHeader("Command", "Unknown command, try \"ripanims, ripmodels, ripsounds, or ripimages\"");
+					Console::WriteLineHeader("Command", "Unknown command, try \"ripanims, ripmodels, ripsounds, ripimages, or catalog\"");
 				}
 			}
 		}